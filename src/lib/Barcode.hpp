@@ -5,21 +5,94 @@
 #include <string>
 #include <zlib.h>
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstring>
 
 #include "helper.hpp"
+#include "PackedSequence.hpp"
+#include "BarcodeIndex.hpp"
+#include "WhitelistAnalysis.hpp"
+#include "LinkerSearch.hpp"
+#include "OffsetModel.hpp"
 
 class Barcode;
 typedef std::shared_ptr<Barcode> BarcodePatternPtr;
 typedef std::vector<BarcodePatternPtr> BarcodePatternVector; 
 typedef std::shared_ptr<BarcodePatternVector> BarcodePatternVectorPtr; 
 
-struct mappingSolution{             
-    int seq_start;
-    int seq_end;
-    int score = INT_MAX;
-    std::string realBarcode;
-    int differenceInBarcodeLength;
-}; 
+//number of independently locked parts of a result cache (threads only wait for each other if their keys are in the same shard)
+#define MATCH_CACHE_SHARDS 64
+
+//all outputs of a call to match_pattern, the caller owns it and reuses it for all barcodes of a read:
+//realBarcode views a pattern of the barcode (or the read for wildcards), differenceInBarcodeLength is also an input (windows to try)
+struct matchResult{
+    bool matched = false;
+    int seq_start = 0;
+    int seq_end = 0;
+    int score = 0;
+    std::string_view realBarcode;
+    int differenceInBarcodeLength = 0;
+};
+
+/**
+ * @brief bounded cache of the results of match_pattern, shared by all threads. The key contains all bases of the read a result depends on
+ * (together with the parameters of the call). Every key has exactly one slot, a new key replaces the old entry of its slot.
+ **/
+class MatchResultCache
+{
+    public:
+    MatchResultCache(const int& capacity)
+    {
+        const int slotsPerShard = MAX(1, capacity / MATCH_CACHE_SHARDS);
+        for(int shardIdx = 0; shardIdx < MATCH_CACHE_SHARDS; ++shardIdx)
+        {
+            shards.push_back(std::make_unique<cacheShard>());
+            shards.back()->slots.resize(slotsPerShard);
+        }
+    }
+
+    bool find(const std::string& key, matchResult& result)
+    {
+        const size_t hash = std::hash<std::string>()(key);
+        cacheShard& shard = *shards[hash % MATCH_CACHE_SHARDS];
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            const std::pair<std::string, matchResult>& slot = shard.slots[(hash / MATCH_CACHE_SHARDS) % shard.slots.size()];
+            if(slot.first == key)
+            {
+                result = slot.second;
+                ++hits;
+                return true;
+            }
+        }
+        ++misses;
+        return false;
+    }
+
+    void insert(const std::string& key, const matchResult& result)
+    {
+        const size_t hash = std::hash<std::string>()(key);
+        cacheShard& shard = *shards[hash % MATCH_CACHE_SHARDS];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        shard.slots[(hash / MATCH_CACHE_SHARDS) % shard.slots.size()] = std::make_pair(key, result);
+    }
+
+    unsigned long long get_hits() const {return hits;}
+    unsigned long long get_misses() const {return misses;}
+
+    private:
+    struct cacheShard
+    {
+        std::mutex lock;
+        std::vector<std::pair<std::string, matchResult> > slots;
+    };
+    std::vector<std::unique_ptr<cacheShard> > shards;
+    std::atomic<unsigned long long> hits = 0;
+    std::atomic<unsigned long long> misses = 0;
+};
+typedef std::shared_ptr<MatchResultCache> MatchResultCachePtr;
 
 //new datatypes
 class Barcode
@@ -27,52 +100,101 @@ class Barcode
     public:
     Barcode(int inMismatches) : mismatches(inMismatches) {}
     int mismatches;
-    //reverse complement is a Barcode function that should be available globally
+    //reverse complement is a Barcode function that should be available globally (throws std::domain_error for invalid nucleotides)
     static std::string generate_reverse_complement(std::string seq)
     {
-        auto lambda = [](const char c) 
-        {
-            switch (c) 
-            {
-                case 'A':
-                    return 'T';
-                case 'G':
-                    return 'C';
-                case 'C':
-                    return 'G';
-                case 'T':
-                    return 'A';
-                case 'N':
-                    return 'N';
-                default:
-                    throw std::domain_error("Invalid nucleotide.");
-            }
-        };
-        std::string newSeq = seq;
-        std::transform(seq.crbegin(), seq.crend(), newSeq.begin(), lambda);
-        return newSeq;
+        return reverse_complement(seq);
     }
-    //overwritten function to match sequence pattern(s)
-    virtual bool match_pattern(std::string sequence, const int& offset, int& seq_start, int& seq_end, int& score, std::string& realBarcode, 
-                               int& differenceInBarcodeLength, bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false) = 0;
-    virtual std::vector<std::string> get_patterns() = 0;
+    //overwritten function to match sequence pattern(s), the read is only viewed and the result written into result
+    virtual bool match_pattern(std::string_view sequence, const int& offset, matchResult& result, 
+                               bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false) = 0;
+    //the barcode exactly at offset (no shifted windows, no alignment): if true, the result is the one match_pattern returns for this offset,
+    //if false match_pattern has to be called (the barcode might still map with mismatches or at another position)
+    virtual bool match_exact(std::string_view sequence, const int& offset, matchResult& result, bool reverse = false){return false;}
+    virtual const std::vector<std::string>& get_patterns() = 0; //stored in the barcode, no copy per call
     virtual bool is_wildcard() = 0;
     virtual bool is_constant() = 0;
     virtual bool is_stop() = 0;
+    //description of how the barcode is matched (whitelist properties and the search used), empty if there is nothing to choose
+    virtual std::string describe_matching_plan(){return "";}
+    //windows that were not mapped because the traceback of the best pattern did not confirm the score of the lanes or indexes
+    virtual unsigned long long get_traceback_disagreements() const {return 0;}
+    //search of all linkers of a read in one scan (only constant barcodes use it): the barcode is then matched to the whole remaining
+    //read (sequence, starting at readOffset of the scanned read) with the scores of the scan
+    virtual void set_anchor_search(const LinkerAnchorSearchPtr& inAnchorSearch){}
+    virtual LinkerAnchorSearchPtr get_anchor_search() const {return nullptr;}
+    virtual bool match_anchor(std::string_view sequence, const linkerScores& scan, const int& readOffset, matchResult& result)
+    {
+        return match_pattern(sequence, 0, result, false, false, true);
+    }
+
+    //cache the results of match_pattern with up to capacity entries (capacity 0 disables the cache), only for variable barcodes:
+    //the key of a constant barcode spans the whole linker plus its mismatches and is hardly ever seen twice
+    void enable_result_cache(const int& capacity)
+    {
+        resultCache = nullptr;
+        if(capacity <= 0 || is_constant() || is_wildcard() || is_stop()){return;}
+        resultCache = std::make_shared<MatchResultCache>(capacity);
+        maxPatternLength = 0;
+        for(const std::string& pattern : get_patterns()){maxPatternLength = MAX(maxPatternLength, (int)pattern.length());}
+    }
+    const MatchResultCachePtr& get_result_cache() const {return resultCache;}
+
+    //match_pattern, for a window of the read that was seen before the result is taken from the cache (if there is one)
+    bool match_pattern_cached(std::string_view sequence, const int& offset, matchResult& result, 
+                              bool startCorrection = false,  bool reverse = false, bool fullLengthMapping = false)
+    {
+        //mappings to the whole read are not cached (the key would be the whole read), neither are wildcards (their result views the read)
+        if( (resultCache == nullptr) || fullLengthMapping || is_wildcard() )
+        {
+            return match_pattern(sequence, offset, result, startCorrection, reverse, fullLengthMapping);
+        }
+
+        //match_pattern reads at most mismatches bases before the offset (start correction) and after the last window of the longest pattern
+        //(extension of the end); the key stores the parameters of the call as text (offset within the stored bases, windows to try, 
+        //start correction and reverse) followed by these bases, e.g. '1|0|SR|ACGT...'
+        const int keyStart = MAX(0, offset - mismatches);
+        const int keyEnd = MIN((int)sequence.length(), offset + MAX(0, result.differenceInBarcodeLength) + maxPatternLength + mismatches);
+        thread_local std::string key; //reused by all calls of a thread
+        key = std::to_string(offset - keyStart);
+        key += '|';
+        key += std::to_string(result.differenceInBarcodeLength);
+        key += '|';
+        key += (startCorrection ? 'S' : '-');
+        key += (reverse ? 'R' : '-');
+        key += '|';
+        if(keyEnd > keyStart){key.append(sequence.substr(keyStart, keyEnd - keyStart));}
+
+        if(!resultCache->find(key, result))
+        {
+            match_pattern(sequence, offset, result, startCorrection, reverse, fullLengthMapping);
+            resultCache->insert(key, result);
+        }
+        return result.matched;
+    }
+
+    private:
+    MatchResultCachePtr resultCache = nullptr;
+    int maxPatternLength = 0;
 };
 
 class ConstantBarcode : public Barcode
 {
 
     public:
-    ConstantBarcode(std::string inPattern, int inMismatches) : pattern(inPattern),Barcode(inMismatches) 
+    ConstantBarcode(std::string inPattern, int inMismatches) : Barcode(inMismatches), pattern(inPattern), patternList({inPattern}) 
     {
         revCompPattern = generate_reverse_complement(pattern);
     }
-    bool match_pattern(std::string sequence, const int& offset, int& seq_start, int& seq_end, int& score, std::string& realBarcode, 
-                       int& differenceInBarcodeLength, bool startCorrection = false, bool reverse = false,
+    bool match_pattern(std::string_view sequence, const int& offset, matchResult& result, bool startCorrection = false, bool reverse = false,
                        bool fullLengthMapping = false)
     {
+        int& seq_start = result.seq_start;
+        int& seq_end = result.seq_end;
+        int& score = result.score;
+        std::string_view& realBarcode = result.realBarcode;
+        int& differenceInBarcodeLength = result.differenceInBarcodeLength;
+        result.matched = false;
 
         int tries = differenceInBarcodeLength;
         int tmpOffset = offset;
@@ -81,7 +203,8 @@ class ConstantBarcode : public Barcode
 
         //increment offset each round
         bool matchFound = false;
-        mappingSolution tmpSolution;
+        matchResult tmpSolution;
+        tmpSolution.score = INT_MAX;
 
         //iterate over tries, and keep first found solution
         while(tries >= 0)
@@ -94,7 +217,7 @@ class ConstantBarcode : public Barcode
             if(matchResult && score < tmpSolution.score)
             {
                 matchFound = true;
-                tmpSolution = {seq_start, seq_end,score , realBarcode, differenceInBarcodeLength};
+                tmpSolution = result;
                 break;
             }
 
@@ -112,46 +235,75 @@ class ConstantBarcode : public Barcode
         if(!matchFound){return false;}
 
         //else store best solution in origional variables
-        seq_start = tmpSolution.seq_start;
-        seq_end = tmpSolution.seq_end;
-        score = tmpSolution.score;
-        realBarcode = tmpSolution.realBarcode;
-        differenceInBarcodeLength = tmpSolution.differenceInBarcodeLength;
+        result = tmpSolution;
+        result.matched = true;
 
         return true;
     }
-    std::vector<std::string> get_patterns()
+    const std::vector<std::string>& get_patterns()
     {
-        std::vector<std::string> patterns = {pattern};
-        return patterns;
+        return patternList;
+    }
+    bool match_exact(std::string_view sequence, const int& offset, matchResult& result, bool reverse = false)
+    {
+        const std::string& usedPattern = reverse ? revCompPattern : pattern;
+        if( (offset + usedPattern.length() > sequence.length()) || (std::memcmp(sequence.data() + offset, usedPattern.data(), usedPattern.length()) != 0) )
+        {
+            return false;
+        }
+        result = {true, 0, (int)pattern.length(), 0, pattern, 0};
+        return true;
     }
     bool is_wildcard(){return false;}
     bool is_constant(){return true;}
     bool is_stop(){return false;}
 
+    void set_anchor_search(const LinkerAnchorSearchPtr& inAnchorSearch)
+    {
+        anchorSearch = inAnchorSearch;
+        anchorIdx = (anchorSearch == nullptr) ? -1 : anchorSearch->linker_index(pattern);
+    }
+    LinkerAnchorSearchPtr get_anchor_search() const {return anchorSearch;}
+    bool match_anchor(std::string_view sequence, const linkerScores& scan, const int& readOffset, matchResult& result)
+    {
+        //same as match_pattern with offset 0 and fullLengthMapping (a single try)
+        result.differenceInBarcodeLength = 0;
+        result.matched = private_match_pattern(sequence, 0, 0, result.seq_start, result.seq_end, result.score, result.realBarcode, false, 
+                                               result.differenceInBarcodeLength, false, false, true, &scan, readOffset);
+        return result.matched;
+    }
+
     private:
-    bool private_match_pattern(std::string sequence, const int& offset, const int& offsetShiftValue, int& seq_start, int& seq_end, 
-                               int& score, std::string& realBarcode, const bool& offsetShiftBool, int& diffEnd,
-                               bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false)
+    //anchorScan: scores of the linker in the read that sequence is part of (from readOffset on), the read is then not searched again
+    bool private_match_pattern(std::string_view sequence, const int& offset, const int& offsetShiftValue, int& seq_start, int& seq_end, 
+                               int& score, std::string_view& realBarcode, const bool& offsetShiftBool, int& diffEnd,
+                               bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false,
+                               const linkerScores* anchorScan = nullptr, const int& readOffset = 0)
     {
         //set the pattern to use for reverse or forward mapping
-        std::string usedPattern = pattern;
-        if(reverse){usedPattern = revCompPattern;}
+        const std::string& usedPattern = reverse ? revCompPattern : pattern;
 
-        std::string subSequence;
+        //the whole read is searched for the pattern in one scan, only the best hit is aligned with backtracking
+        std::string_view subSequence = sequence;
         if(!fullLengthMapping)
         {
-            subSequence = sequence.substr(offset, pattern.length());
-        }
-        else
-        {
-            subSequence = sequence;
+            subSequence = subSequence.substr(offset, pattern.length());
         }
 
         int endInPattern = 0; // store the number of missing bases in the pattern (in this case we might have to elongate the mapped sequence)
         // e.g.: [AGTAGT]cccc: start=0 end=6 end is first not included idx
         int startInPattern = 0;
-        if(levenshtein(subSequence, usedPattern, mismatches, seq_start, seq_end, score, endInPattern, startInPattern))
+        bool mapped = false;
+        if(fullLengthMapping && (anchorScan != nullptr) && !reverse && (anchorIdx >= 0))
+        {
+            mapped = anchorSearch->find(*anchorScan, anchorIdx, subSequence, readOffset, mismatches, seq_start, seq_end, score, endInPattern, startInPattern);
+        }
+        else
+        {
+            mapped = fullLengthMapping ? levenshtein_search(subSequence, usedPattern, mismatches, seq_start, seq_end, score, endInPattern, startInPattern, true)
+                                       : levenshtein(subSequence, usedPattern, mismatches, seq_start, seq_end, score, endInPattern, startInPattern, true);
+        }
+        if(mapped)
         {
             //seq_start starts potentially with 1, and seq_end is in a perfect match length (zero row, col is filled with zeroes in edit-dist)
             int differencePatternLengthMappingLength = pattern.length()-(seq_end);
@@ -174,7 +326,7 @@ class ConstantBarcode : public Barcode
             //if we have not mathced the whole pattern to subsequence and we can even still elongate to the end of the subsequence in the read
             if( (differencePatternLengthMappingLength == 0) && (diffEnd > 0) && (sequence.length() >= offset + pattern.length() + differencePatternLengthMappingLength) )
             {
-                std::string subSequenceElongated = sequence.substr(offset, pattern.length() + diffEnd);
+                std::string_view subSequenceElongated = sequence.substr(offset, pattern.length() + diffEnd);
                 if(subSequence.length() != subSequenceElongated.length() && seq_end < subSequenceElongated.length())
                 {
                     int extension = backBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_end, endInPattern);
@@ -187,7 +339,7 @@ class ConstantBarcode : public Barcode
             if(startInPattern > 0 && startCorrection && (offset >= startInPattern) )
             {
                 //we have startInPattern additional bases to check before sequence
-                std::string subSequenceElongated = sequence.substr(offset-startInPattern, pattern.length());
+                std::string_view subSequenceElongated = sequence.substr(offset-startInPattern, pattern.length());
                 int extension = frontBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_start, startInPattern);
                 seq_start -= extension;
             }
@@ -201,30 +353,91 @@ class ConstantBarcode : public Barcode
         }
     }
     std::string pattern;
+    std::vector<std::string> patternList; //the pattern as returned by get_patterns
     std::string revCompPattern;
+    LinkerAnchorSearchPtr anchorSearch = nullptr;
+    int anchorIdx = -1; //index of the pattern in the anchor search
 };
+//how the windows of a variable barcode are matched to its patterns (chosen with a prefix of its mismatches, e.g. h1 or a1):
+//HAMMING matches windows with substitutions only (Hamming distance) and aligns them only if no pattern is within the mismatches,
+//LEVENSHTEIN_AUTOMATON walks a trie of the patterns with the Levenshtein automaton for every window (same results as the alignment)
+enum class matchingMode {EDIT_DISTANCE, HAMMING, LEVENSHTEIN_AUTOMATON};
+
 class VariableBarcode : public Barcode
 {
 
     public:
-    VariableBarcode(std::vector<std::string> inPatterns, int inMismatches) : patterns(inPatterns), Barcode(inMismatches) 
+    VariableBarcode(std::vector<std::string> inPatterns, int inMismatches, matchingMode matching = matchingMode::EDIT_DISTANCE) 
+    : Barcode(inMismatches), patterns(inPatterns) 
     {
         for(std::string pattern : patterns)
         {
             std::string revCompPattern = generate_reverse_complement(pattern);
             revCompPatterns.push_back(revCompPattern);
         }
+        patternLaneGroups = generate_pattern_lanes(patterns);
+        revCompPatternLaneGroups = generate_pattern_lanes(revCompPatterns);
+        //the reverse complements have the same lengths and distances
+        whitelist = analyse_whitelist(patterns, mismatches);
+        uniqueScore = unique_score(whitelist, mismatches);
+        specialise_pattern_lanes(patternLaneGroups, mismatches);
+        specialise_pattern_lanes(revCompPatternLaneGroups, mismatches);
+        exactIndexes = generate_exact_indexes(patterns, patternLaneGroups);
+        revCompExactIndexes = generate_exact_indexes(revCompPatterns, revCompPatternLaneGroups);
+        if( (matching == matchingMode::HAMMING) && (mismatches > 0) )
+        {
+            hammingIndexes = generate_hamming_indexes(patterns, patternLaneGroups);
+            revCompHammingIndexes = generate_hamming_indexes(revCompPatterns, revCompPatternLaneGroups);
+        }
+        hammingNotPossible = (matching == matchingMode::HAMMING) && (mismatches > 0) && hammingIndexes.empty();
+        if( (matching == matchingMode::LEVENSHTEIN_AUTOMATON) && (mismatches > 0) )
+        {
+            patternTries = generate_automaton_tries(patterns, patternLaneGroups, mismatches);
+            revCompPatternTries = generate_automaton_tries(revCompPatterns, revCompPatternLaneGroups, mismatches);
+        }
+        automatonMatching = !patternTries.empty();
+        automatonNotPossible = (matching == matchingMode::LEVENSHTEIN_AUTOMATON) && (mismatches > 0) && !automatonMatching;
+        //exact matches are already found with the exact index, with the Levenshtein automaton all other windows are matched with the tries
+        if( (mismatches > 0) && !automatonMatching )
+        {
+            neighbourhoodIndexes = generate_neighbourhood_indexes(patterns, patternLaneGroups, mismatches);
+            revCompNeighbourhoodIndexes = generate_neighbourhood_indexes(revCompPatterns, revCompPatternLaneGroups, mismatches);
+        }
+        else
+        {
+            neighbourhoodIndexes.assign(patternLaneGroups.size(), nullptr);
+            revCompNeighbourhoodIndexes.assign(revCompPatternLaneGroups.size(), nullptr);
+        }
+        if(automatonMatching)
+        {
+            seedIndexes.assign(patternLaneGroups.size(), nullptr);
+            revCompSeedIndexes.assign(revCompPatternLaneGroups.size(), nullptr);
+        }
+        else
+        {
+            seedIndexes = generate_seed_indexes(patterns, patternLaneGroups, neighbourhoodIndexes, mismatches);
+            revCompSeedIndexes = generate_seed_indexes(revCompPatterns, revCompPatternLaneGroups, revCompNeighbourhoodIndexes, mismatches);
+            patternTries = generate_pattern_tries(patterns, patternLaneGroups, neighbourhoodIndexes, seedIndexes, mismatches);
+            revCompPatternTries = generate_pattern_tries(revCompPatterns, revCompPatternLaneGroups, revCompNeighbourhoodIndexes, revCompSeedIndexes, mismatches);
+        }
     }
-    bool match_pattern(std::string sequence, const int& offset, int& seq_start, int& seq_end, int& score, std::string& realBarcode, 
-                       int& differenceInBarcodeLength, bool startCorrection = false,  bool reverse = false, bool fullLengthMapping = false)
+    bool match_pattern(std::string_view sequence, const int& offset, matchResult& result, bool startCorrection = false,  bool reverse = false, 
+                       bool fullLengthMapping = false)
     {
+        int& seq_start = result.seq_start;
+        int& seq_end = result.seq_end;
+        int& score = result.score;
+        std::string_view& realBarcode = result.realBarcode;
+        int& differenceInBarcodeLength = result.differenceInBarcodeLength;
+        result.matched = false;
 
         int tries = differenceInBarcodeLength;
         int tmpOffset = offset;
         bool offsetShiftBool = false;
         int offsetShiftValue = 0;
         int numberOfSameScoreResults = 0;
-        mappingSolution tmpSolution;
+        matchResult tmpSolution;
+        tmpSolution.score = INT_MAX;
         //iterate over tries, and keep first found solution
         while(tries >= 0)
         {
@@ -235,7 +448,7 @@ class VariableBarcode : public Barcode
             //could be extended to iterate over all tries and only keep best solution
             if(matchResult && score < tmpSolution.score)
             {
-                tmpSolution = {seq_start, seq_end,score , realBarcode, differenceInBarcodeLength};
+                tmpSolution = result;
                 numberOfSameScoreResults = tmpNumberOfSameScoreResults;
 
                 break;
@@ -271,141 +484,338 @@ class VariableBarcode : public Barcode
         {
 
             //else store best solution in origional variables
-            seq_start = tmpSolution.seq_start;
-            seq_end = tmpSolution.seq_end;
-            score = tmpSolution.score;
-            realBarcode = tmpSolution.realBarcode;
-            differenceInBarcodeLength = tmpSolution.differenceInBarcodeLength;
+            result = tmpSolution;
+            result.matched = true;
 
             return true;
         }
 
         return false;
     }
-    std::vector<std::string> get_patterns()
+    const std::vector<std::string>& get_patterns()
     {
         return patterns;
     }
+    //exact hash lookup of the windows at offset, the same lookup match_pattern starts with (only if exactly one pattern matches)
+    bool match_exact(std::string_view sequence, const int& offset, matchResult& result, bool reverse = false)
+    {
+        laneAlignmentResult exactResult;
+        if(!find_exact_matches(sequence, offset, reverse, exactResult) || (exactResult.bestCount != 1)){return false;}
+        const std::string& pattern = patterns.at(exactResult.bestIdx);
+        result = {true, 0, (int)pattern.length(), 0, pattern, 0};
+        return true;
+    }
     bool is_wildcard(){return false;}
     bool is_constant(){return false;}
     bool is_stop(){return false;}
 
+    unsigned long long get_traceback_disagreements() const {return tracebackDisagreements->load(std::memory_order_relaxed);}
+
+    //whitelist properties and the search used for every length of patterns (the indexes are chosen when the barcode is constructed),
+    //warns if reads are often equally close to several patterns
+    std::string describe_matching_plan()
+    {
+        const whitelistAnalysis& analysis = whitelist;
+        std::string plan = std::to_string(analysis.patternNumber) + " patterns | lengths:";
+        for(const std::pair<const int, int>& lengthCount : analysis.lengthDistribution)
+        {
+            plan += " " + std::to_string(lengthCount.first) + "(" + std::to_string(lengthCount.second) + ")";
+        }
+        plan += " | minimum edit distance: ";
+        if(analysis.sampled){plan += "<=";}
+        else if(analysis.minDistance == analysis.distanceCap){plan += ">=";}
+        plan += std::to_string(analysis.minDistance) + (analysis.sampled ? " (sampled)" : "");
+        std::string mode = (!hammingIndexes.empty() || hammingNotPossible) ? "h" : "";
+        if(automatonMatching || automatonNotPossible){mode = "a";}
+        plan += " | mismatches: " + mode + std::to_string(mismatches) + "\n";
+        for(int groupIdx = 0; groupIdx < (int)patternLaneGroups.size(); ++groupIdx)
+        {
+            plan += "\tlength " + std::to_string(patternLaneGroups.at(groupIdx).length) + ": " + describe_group_search(groupIdx) + "\n";
+        }
+        if(uniqueScore > 0)
+        {
+            plan += "\tpatterns are unique up to " + std::to_string(uniqueScore) + " mismatches: the alignment to all patterns stops at the first of them\n";
+        }
+        if( (analysis.patternNumber > 1) && (2 * mismatches >= analysis.minDistance) )
+        {
+            plan += "\tWARNING: mismatches are at least half the minimum edit distance of the patterns, reads can be equally close to several patterns "
+                    "and are then discarded. Consider fewer mismatches.\n";
+        }
+        return plan;
+    }
+
     private:
+    //search of one group of patterns of same length in the order it is tried in private_match_pattern
+    std::string describe_group_search(const int& groupIdx)
+    {
+        std::string search = (exactIndexes.at(groupIdx) != nullptr) ? "exact hash" : "";
+        if( (mismatches == 0) && (exactIndexes.at(groupIdx) != nullptr) ){return search;}
+        if(!search.empty()){search += ", then ";}
+        if(!hammingIndexes.empty())
+        {
+            search += "Hamming scan of all patterns (popcount), if there is no hit: ";
+        }
+        else if(hammingNotPossible)
+        {
+            search += "(no Hamming matching: patterns are longer than 32 bases or contain other bases than ACGT) ";
+        }
+        else if(automatonNotPossible)
+        {
+            search += "(no Levenshtein automaton: patterns contain other bases than ACGT or are not longer than the mismatches) ";
+        }
+        if(neighbourhoodIndexes.at(groupIdx) != nullptr)
+        {
+            search += "edit-neighbourhood hash";
+        }
+        else if(seedIndexes.at(groupIdx) != nullptr)
+        {
+            search += "q-gram seed filter with alignment of the candidates";
+        }
+        else if(patternTries.at(groupIdx) != nullptr)
+        {
+            search += (mismatches <= LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES) ? "prefix trie with Levenshtein automaton" : "prefix trie with banded alignment";
+        }
+        else
+        {
+            search += (patternLaneGroups.at(groupIdx).fixedKernel != nullptr) ? "SIMD alignment of all patterns (specialised kernel)" : "SIMD alignment of all patterns";
+        }
+        return search;
+    }
+
     // IMPROVE FUNCTION:
     //      window size is: bases unmatched at end of previous sequence + mismatches for this barcode
     //      instead of one long seq with more allowed mismatches: move along a window and get barcode
 
     // first only for number of skipped bases call a sequences window; if this leads to nothing add more windows until number mismatches in barcode is reached
-    bool private_match_pattern(std::string sequence, const int& offset, const int& offsetShiftValue, int& seq_start, int& seq_end, int& score, 
-                               std::string& realBarcode, const bool& offsetShiftBool, int& numberOfSameScoreResults, int& diffEnd,
+    bool private_match_pattern(std::string_view sequence, const int& offset, const int& offsetShiftValue, int& seq_start, int& seq_end, int& score, 
+                               std::string_view& realBarcode, const bool& offsetShiftBool, int& numberOfSameScoreResults, int& diffEnd,
                                bool reverse = false, bool startCorrection = false)
     {
+        //score the window against all patterns at once (SIMD lanes for patterns of same length), 
+        //only the best pattern is aligned again with backtracking to get the mapping positions
+        //if there is an index of the edit-neighbourhood of the patterns a lookup replaces the alignment,
+        //for large lists of patterns a seed index selects the patterns that are aligned or a trie aligns shared prefixes only once
+        std::vector<patternLanes>& laneGroups = reverse ? revCompPatternLaneGroups : patternLaneGroups;
+        std::vector<EditNeighbourhoodIndexPtr>& indexes = reverse ? revCompNeighbourhoodIndexes : neighbourhoodIndexes;
+        std::vector<SeedCandidateIndexPtr>& candidateIndexes = reverse ? revCompSeedIndexes : seedIndexes;
+        std::vector<PatternTriePtr>& tries = reverse ? revCompPatternTries : patternTries;
+        laneAlignmentResult bestResult;
+        bestResult.bestScore = mismatches + 1;
+
+        //firstly look for exact matches: if there is one no pattern can be better and the approximate search is skipped
+        bool exactSearchComplete = find_exact_matches(sequence, offset, reverse, bestResult);
+        //in Hamming mode a window with substitutions only is matched without any alignment, 
+        //the edit distance is only used if no pattern is within the mismatches
+        if(!exactSearchComplete && !hammingIndexes.empty() && find_hamming_matches(sequence, offset, reverse, bestResult))
+        {
+            score = bestResult.bestScore;
+            if(bestResult.bestCount > 1)
+            {
+                ++numberOfSameScoreResults;
+                return false;
+            }
+            seq_start = offsetShiftBool ? offsetShiftValue : 0;
+            seq_end = seq_start + patterns.at(bestResult.bestIdx).length();
+            diffEnd = 0;
+            realBarcode = patterns.at(bestResult.bestIdx);
+            numberOfSameScoreResults = 0;
+            return true;
+        }
+        for(int groupIdx = 0; (groupIdx < (int)laneGroups.size()) && !exactSearchComplete; ++groupIdx)
+        {
+            const patternLanes& lanes = laneGroups.at(groupIdx);
+            std::string_view window = sequence.substr(offset, lanes.length);
+            laneAlignmentResult result;
+            bool lookedUp = (indexes.at(groupIdx) != nullptr) && indexes.at(groupIdx)->lookup(window, result);
+            if(!lookedUp && (candidateIndexes.at(groupIdx) != nullptr))
+            {
+                candidateIndexes.at(groupIdx)->lookup(window, result);
+            }
+            else if(!lookedUp && (tries.at(groupIdx) != nullptr))
+            {
+                tries.at(groupIdx)->lookup(window, result);
+            }
+            else if(!lookedUp)
+            {
+                levenshtein_lanes(window, lanes, mismatches, result, supported_lane_kernel(), uniqueScore);
+            }
+            if(result.bestScore < bestResult.bestScore)
+            {
+                bestResult = result;
+            }
+            else if( (result.bestCount > 0) && (result.bestScore == bestResult.bestScore) )
+            {
+                bestResult.bestCount += result.bestCount;
+                bestResult.bestIdx = MIN(bestResult.bestIdx, result.bestIdx);
+            }
+        }
 
-        int match_count = 0;
-        bool found_match = false;
-        int best_start = 0, best_end = 0, best_score = mismatches+1, tmpDiff = 0, bestDiff = 0;
+        //compare all results for different patterns
+        if(bestResult.bestCount == 0)
+        {
+            numberOfSameScoreResults = 0;
+            diffEnd = 0;
+            return false;
+        }
+        else if(bestResult.bestCount > 1)
+        {
+            score = bestResult.bestScore;
 
-        std::vector<std::string> patternsToMap = patterns;
-        if(reverse){patternsToMap = revCompPatterns;}
+            ++numberOfSameScoreResults;
+            return false;
+        }
 
-        for(int patternIdx = 0; patternIdx!= patternsToMap.size(); ++patternIdx)
+        bool aligned = align_pattern(sequence, bestResult.bestIdx, offset, offsetShiftValue, offsetShiftBool, seq_start, seq_end, score, diffEnd, 
+                                     reverse, startCorrection);
+        //the traceback must confirm the score of the index or lanes, otherwise this window is not mapped and counted, so that the run 
+        //finishes and reports it in a warning instead of aborting
+        if(!aligned || (score != bestResult.bestScore))
         {
-            std::string pattern = patterns.at(patternIdx);
-            std::string usedPattern = patternsToMap.at(patternIdx);
-
-            std::string subSequence = sequence.substr(offset, pattern.length());
+            tracebackDisagreements->fetch_add(1, std::memory_order_relaxed);
+            numberOfSameScoreResults = 0;
+            diffEnd = 0;
+            return false;
+        }
+        realBarcode = patterns.at(bestResult.bestIdx);
+        numberOfSameScoreResults = 0;
+        return true;
+    }
 
-            score = 0;
-            seq_start = 0;
-            seq_end = 0;
-            int endInPattern = 0; // store the number of missing bases in the pattern (in this case we might have to elongate the mapped sequence)
-            int startInPattern = 0;
+    //exact matches of the window in all groups of patterns, the result is complete if a pattern matches exactly 
+    //or if there is no exact match and mismatches are not allowed (as long as all groups have an exact index)
+    bool find_exact_matches(std::string_view sequence, const int& offset, bool reverse, laneAlignmentResult& bestResult)
+    {
+        std::vector<patternLanes>& laneGroups = reverse ? revCompPatternLaneGroups : patternLaneGroups;
+        std::vector<ExactBarcodeIndexPtr>& indexes = reverse ? revCompExactIndexes : exactIndexes;
+        laneAlignmentResult exactResult;
+        exactResult.bestScore = 0;
+        for(int groupIdx = 0; groupIdx < (int)laneGroups.size(); ++groupIdx)
+        {
+            if(indexes.at(groupIdx) == nullptr){return false;}
+            laneAlignmentResult result;
+            indexes.at(groupIdx)->lookup(sequence.substr(offset, laneGroups.at(groupIdx).length), result);
+            if(result.bestCount > 0)
+            {
+                exactResult.bestCount += result.bestCount;
+                exactResult.bestIdx = (exactResult.bestIdx < 0) ? result.bestIdx : MIN(exactResult.bestIdx, result.bestIdx);
+            }
+        }
+        if(exactResult.bestCount > 0)
+        {
+            bestResult = exactResult;
+            return true;
+        }
+        return (mismatches == 0);
+    }
 
-            if(levenshtein(subSequence, usedPattern, mismatches, seq_start, seq_end, score, endInPattern, startInPattern))
+    //best Hamming distance of the window to all patterns, true if a pattern is within the mismatches
+    bool find_hamming_matches(std::string_view sequence, const int& offset, bool reverse, laneAlignmentResult& bestResult)
+    {
+        std::vector<patternLanes>& laneGroups = reverse ? revCompPatternLaneGroups : patternLaneGroups;
+        std::vector<HammingBarcodeIndexPtr>& indexes = reverse ? revCompHammingIndexes : hammingIndexes;
+        laneAlignmentResult hammingResult;
+        hammingResult.bestScore = mismatches + 1;
+        for(int groupIdx = 0; groupIdx < (int)laneGroups.size(); ++groupIdx)
+        {
+            laneAlignmentResult result;
+            indexes.at(groupIdx)->lookup(sequence.substr(offset, laneGroups.at(groupIdx).length), mismatches, result);
+            if(result.bestCount == 0){continue;}
+            if(result.bestScore < hammingResult.bestScore)
             {
-                //seq_start starts potentially with 1, and seq_end is in a perfect match length (edit dist has zeroes in first row, col)
-                int differencePatternLengthMappingLength = pattern.length()-(seq_end);
-                tmpDiff = pattern.length()-endInPattern;
-                //we only set the offset based on mapping differencen when: 
-                //1.) the sequence is not mapped fully to the pattern (therefore, there must have been deletion) 
-                //2.) the pattern is mapped till the end (below)
-                if(tmpDiff!= 0){differencePatternLengthMappingLength = 0;}
-
-                if(offsetShiftBool)
-                {
-                    seq_start = seq_start+offsetShiftValue;
-                    seq_end = seq_end+offsetShiftValue;
-                }
+                hammingResult = result;
+            }
+            else if(result.bestScore == hammingResult.bestScore)
+            {
+                hammingResult.bestCount += result.bestCount;
+                hammingResult.bestIdx = MIN(hammingResult.bestIdx, result.bestIdx);
+            }
+        }
+        if(hammingResult.bestCount == 0){return false;}
+        bestResult = hammingResult;
+        return true;
+    }
 
-                //int differencePatternLengthMappingLength = pattern.length() - seq_end;
-                //if we have not mathced the whole pattern to subsequence and we can even still elongate to the end of the subsequence in the read
-                if( (differencePatternLengthMappingLength == 0) && (tmpDiff > 0) && (sequence.length() >= offset + pattern.length() + differencePatternLengthMappingLength) )
-                {
-                    std::string subSequenceElongated = sequence.substr(offset, pattern.length() + tmpDiff);
-                    if(subSequence.length() != subSequenceElongated.length() && seq_end < subSequenceElongated.length())
-                    {
-                        int extension = backBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_end, endInPattern);
-                        seq_end += extension;
-                        tmpDiff -= extension;
-                    }
-                }
+    //align the window to one pattern with backtracking and extend the mapping at its ends if possible
+    bool align_pattern(std::string_view sequence, const int& patternIdx, const int& offset, const int& offsetShiftValue, const bool& offsetShiftBool, 
+                       int& seq_start, int& seq_end, int& score, int& diffEnd, bool reverse, bool startCorrection)
+    {
+        const std::string& pattern = patterns.at(patternIdx);
+        const std::string& usedPattern = reverse ? revCompPatterns.at(patternIdx) : pattern;
 
-                if( (startInPattern > 0) && (offset >=startInPattern) && startCorrection )
-                {
-                    //we have startInPattern additional bases to check before sequence: is only possible if before we had a wildcard
-                    std::string subSequenceElongated = sequence.substr(offset-startInPattern, pattern.length());
+        std::string_view subSequence = sequence.substr(offset, pattern.length());
 
-                    int extension = frontBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_start, startInPattern);
-                    seq_start -= extension;
-                }
-                //score comparison
-                if( (score < best_score))
-                {
-                    best_start = seq_start;
-                    best_end = seq_end;
-                    best_score = score;
-                    realBarcode = pattern;
-                    match_count = 1;
-                    found_match = true;
-                    bestDiff = tmpDiff;
-                }
-                else if( (score == best_score) & found_match)
-                {
-                    ++match_count;
-                }
-            }
+        score = 0;
+        seq_start = 0;
+        seq_end = 0;
+        int endInPattern = 0; // store the number of missing bases in the pattern (in this case we might have to elongate the mapped sequence)
+        int startInPattern = 0;
 
-        }
-        //compare all results for different patterns
-        if(match_count == 0)
+        if(!levenshtein(subSequence, usedPattern, mismatches, seq_start, seq_end, score, endInPattern, startInPattern, true))
         {
-            numberOfSameScoreResults = 0;
-            diffEnd = 0;
             return false;
         }
-        else if(match_count > 1)
+
+        //seq_start starts potentially with 1, and seq_end is in a perfect match length (edit dist has zeroes in first row, col)
+        int differencePatternLengthMappingLength = pattern.length()-(seq_end);
+        diffEnd = pattern.length()-endInPattern;
+        //we only set the offset based on mapping differencen when: 
+        //1.) the sequence is not mapped fully to the pattern (therefore, there must have been deletion) 
+        //2.) the pattern is mapped till the end (below)
+        if(diffEnd!= 0){differencePatternLengthMappingLength = 0;}
+
+        if(offsetShiftBool)
         {
-            seq_start = best_start;
-            seq_end = best_end;
-            score = best_score;
-            diffEnd = bestDiff;
+            seq_start = seq_start+offsetShiftValue;
+            seq_end = seq_end+offsetShiftValue;
+        }
 
-            ++numberOfSameScoreResults;
-            return false;
+        //if we have not mathced the whole pattern to subsequence and we can even still elongate to the end of the subsequence in the read
+        if( (differencePatternLengthMappingLength == 0) && (diffEnd > 0) && (sequence.length() >= offset + pattern.length() + differencePatternLengthMappingLength) )
+        {
+            std::string_view subSequenceElongated = sequence.substr(offset, pattern.length() + diffEnd);
+            if(subSequence.length() != subSequenceElongated.length() && seq_end < (int)subSequenceElongated.length())
+            {
+                int extension = backBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_end, endInPattern);
+                seq_end += extension;
+                diffEnd -= extension;
+            }
         }
-        else
+
+        if( (startInPattern > 0) && (offset >=startInPattern) && startCorrection )
         {
-            seq_start = best_start;
-            seq_end = best_end;
-            score = best_score;
-            diffEnd = bestDiff;
+            //we have startInPattern additional bases to check before sequence: is only possible if before we had a wildcard
+            std::string_view subSequenceElongated = sequence.substr(offset-startInPattern, pattern.length());
 
-            numberOfSameScoreResults = 0;
-            return true;
+            int extension = frontBarcodeMappingExtension(subSequenceElongated, usedPattern, seq_start, startInPattern);
+            seq_start -= extension;
         }
+        return true;
     }
+
     std::vector<std::string> patterns;
     std::vector<std::string> revCompPatterns;
+    //patterns grouped by length and transposed for the SIMD alignment
+    std::vector<patternLanes> patternLaneGroups;
+    std::vector<patternLanes> revCompPatternLaneGroups;
+    //exact index, index of the edit-neighbourhood, seed index and trie for each group of lanes (nullptr if there is none), shared between copies of the barcode
+    std::vector<ExactBarcodeIndexPtr> exactIndexes;
+    std::vector<ExactBarcodeIndexPtr> revCompExactIndexes;
+    //Hamming indexes for all groups, empty if Hamming matching is not used
+    std::vector<HammingBarcodeIndexPtr> hammingIndexes;
+    std::vector<HammingBarcodeIndexPtr> revCompHammingIndexes;
+    bool hammingNotPossible = false; //Hamming matching was requested, but the patterns can not be packed
+    bool automatonMatching = false; //all windows that are not an exact match are matched with the tries and the Levenshtein automaton
+    bool automatonNotPossible = false; //the Levenshtein automaton was requested, but the patterns can not be put in a trie
+    whitelistAnalysis whitelist;
+    int uniqueScore = -1; //a pattern aligned with at most this score is the best one (see unique_score), -1 if this is not known
+    std::vector<EditNeighbourhoodIndexPtr> neighbourhoodIndexes;
+    std::vector<EditNeighbourhoodIndexPtr> revCompNeighbourhoodIndexes;
+    std::vector<SeedCandidateIndexPtr> seedIndexes;
+    std::vector<SeedCandidateIndexPtr> revCompSeedIndexes;
+    std::vector<PatternTriePtr> patternTries;
+    std::vector<PatternTriePtr> revCompPatternTries;
+    //windows where the traceback did not confirm the score, shared between copies of the barcode
+    std::shared_ptr<std::atomic<unsigned long long> > tracebackDisagreements = std::make_shared<std::atomic<unsigned long long> >(0);
 
 };
 
@@ -415,23 +825,23 @@ class WildcardBarcode : public Barcode
     //wildcardBarcode doe snot make use of mismatches yet, since anyways we do not know the sequence,
     //therefore its an unused parameter, just set for completeness as these classes derive from Barcode (initialized with mismatches, see up...)
     public:
-    WildcardBarcode(std::string inPattern, int inMismatches) : pattern(inPattern),Barcode(inMismatches) {}
-    bool match_pattern(std::string sequence, const int& offset, int& seq_start, int& seq_end, int& score, std::string& realBarcode, 
-                       int& differenceInBarcodeLength, bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false)
+    WildcardBarcode(std::string inPattern, int inMismatches) : Barcode(inMismatches), pattern(inPattern), patternList({inPattern}) {}
+    bool match_pattern(std::string_view sequence, const int& offset, matchResult& result, bool startCorrection = false, bool reverse = false, 
+                       bool fullLengthMapping = false)
     {
 
         sequence = sequence.substr(offset, pattern.length());
         int end = (sequence.length() < pattern.length()) ? sequence.length() : pattern.length();
         // e.g.: [AGTAGT]cccc: start=0 end=6 end is first not included idx
-        seq_start = 0;
-        seq_end = end;
-        realBarcode = sequence;
+        result.seq_start = 0;
+        result.seq_end = end;
+        result.realBarcode = sequence;
+        result.matched = true;
         return true;
     }
-    std::vector<std::string> get_patterns()
+    const std::vector<std::string>& get_patterns()
     {
-        std::vector<std::string> patterns = {pattern};
-        return patterns;
+        return patternList;
     }
     bool is_wildcard(){return true;}
     bool is_constant(){return false;}
@@ -439,22 +849,23 @@ class WildcardBarcode : public Barcode
 
     private:
     std::string pattern; //just a string of "XXXXX"
+    std::vector<std::string> patternList; //the pattern as returned by get_patterns
 };
 
 
 class StopBarcode : public Barcode
 {
     public:
-    StopBarcode(std::string inPattern, int inMismatches) : pattern(inPattern),Barcode(inMismatches) {}
-    bool match_pattern(std::string sequence, const int& offset, int& seq_start, int& seq_end, int& score, std::string& realBarcode, 
-                       int& differenceInBarcodeLength, bool startCorrection = false, bool reverse = false, bool fullLengthMapping = false)
+    StopBarcode(std::string inPattern, int inMismatches) : Barcode(inMismatches), pattern(inPattern), patternList({inPattern}) {}
+    bool match_pattern(std::string_view sequence, const int& offset, matchResult& result, bool startCorrection = false, bool reverse = false, 
+                       bool fullLengthMapping = false)
     {
+        result.matched = false;
         return false;
     }
-    std::vector<std::string> get_patterns()
+    const std::vector<std::string>& get_patterns()
     {
-        std::vector<std::string> patterns = {pattern};
-        return patterns;
+        return patternList;
     }
     bool is_wildcard(){return false;}
     bool is_constant(){return false;}
@@ -462,4 +873,73 @@ class StopBarcode : public Barcode
 
     private:
     std::string pattern; //just a string of "XXXXX"
-};
\ No newline at end of file
+    std::vector<std::string> patternList; //the pattern as returned by get_patterns
+};
+
+//kind of barcode of a step in a compiled barcode pattern
+enum class barcodeStepType {CONSTANT, VARIABLE, WILDCARD, STOP};
+
+//one barcode of a compiled barcode pattern, with everything the mapping policies need to know about it
+struct barcodePlanStep
+{
+    barcodeStepType type = barcodeStepType::CONSTANT;
+    int length = 0; //length of the (first) pattern, the number of bases of wildcards
+    int mismatches = 0;
+    std::string_view pattern; //the (first) pattern, for constant barcodes the barcode that is written if it is skipped
+    Barcode* barcode = nullptr; //owned by the pattern vector of the plan
+    int nominalOffset = -1; //position in the read if all barcodes in front of it have a fixed length, otherwise -1
+    int anchorIdx = -1; //index of a constant barcode in the anchor search (-1 if it is not searched)
+};
+
+/** @brief flat plan of a barcode pattern that is compiled once from the vector of barcodes: the mapping policies walk through one array
+ * of steps for every read and only call the barcodes to match them (no reference counting, no virtual calls to get type or length)
+ **/
+struct barcodePlan
+{
+    std::vector<barcodePlanStep> steps;
+    const LinkerAnchorSearch* anchorSearch = nullptr; //search of all constant barcodes in one scan (if they have one)
+    BarcodePatternVectorPtr patterns = nullptr; //keeps the barcodes of the steps alive
+    BarcodeOffsetModelPtr offsetModel = nullptr; //offsets learned from the first reads (nullptr if offsets are not learned)
+    std::vector<int> precheckOrder; //constant barcodes that every mapped read contains (in front of a stop), longest first
+};
+
+inline barcodePlan compile_barcode_plan(const BarcodePatternVectorPtr& patterns)
+{
+    barcodePlan plan;
+    plan.patterns = patterns;
+    for(const BarcodePatternPtr& barcode : *patterns)
+    {
+        barcodePlanStep step;
+        step.type = barcode->is_wildcard() ? barcodeStepType::WILDCARD : 
+                    (barcode->is_stop() ? barcodeStepType::STOP : (barcode->is_constant() ? barcodeStepType::CONSTANT : barcodeStepType::VARIABLE));
+        step.pattern = barcode->get_patterns().at(0);
+        step.length = step.pattern.length();
+        step.mismatches = barcode->mismatches;
+        step.barcode = barcode.get();
+        if( (step.type == barcodeStepType::CONSTANT) && (plan.anchorSearch == nullptr) ){plan.anchorSearch = barcode->get_anchor_search().get();}
+        plan.steps.push_back(step);
+    }
+
+    //positions that are known without mapping: all barcodes in front have one length (constants, wildcards, whitelists of one length)
+    int nominalOffset = 0;
+    for(barcodePlanStep& step : plan.steps)
+    {
+        step.nominalOffset = nominalOffset;
+        const std::vector<std::string>& stepPatterns = step.barcode->get_patterns();
+        const bool fixedLength = std::all_of(stepPatterns.begin(), stepPatterns.end(), [&step](const std::string& pattern)
+                                             {return (int)pattern.length() == step.length;});
+        nominalOffset = ( (nominalOffset < 0) || !fixedLength ) ? -1 : (nominalOffset + step.length);
+    }
+
+    //constant barcodes that can be checked before mapping a read: the most selective (longest) first
+    for(int stepIdx = 0; (stepIdx < (int)plan.steps.size()) && (plan.steps[stepIdx].type != barcodeStepType::STOP); ++stepIdx)
+    {
+        barcodePlanStep& step = plan.steps[stepIdx];
+        if( (step.type != barcodeStepType::CONSTANT) || (plan.anchorSearch == nullptr) ){continue;}
+        step.anchorIdx = plan.anchorSearch->linker_index(std::string(step.pattern));
+        if(step.anchorIdx >= 0){plan.precheckOrder.push_back(stepIdx);}
+    }
+    std::stable_sort(plan.precheckOrder.begin(), plan.precheckOrder.end(), [&plan](const int& a, const int& b)
+                     {return plan.steps[a].length > plan.steps[b].length;});
+    return plan;
+}
@@ -0,0 +1,1109 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <random>
+
+#include "helper.hpp"
+#include "PackedSequence.hpp"
+
+//indexes are only built for few mismatches and short patterns (sequences of up to 31 bases fit into one key),
+//and not if the neighbourhood of all patterns gets too large
+#define NEIGHBOURHOOD_INDEX_MAX_MISMATCHES 2
+#define NEIGHBOURHOOD_INDEX_MAX_ENTRIES 5000000
+
+//key of a packed sequence of up to 31 bases: a bit above the bases marks the length (AC and ACA get different keys)
+inline uint64_t length_tagged_key(const uint64_t& packed, const int& length)
+{
+    return packed | (1ULL << (2 * length));
+}
+
+//a minimal perfect hash is built with at most this many levels, keys still colliding afterwards are stored in a sorted list
+#define PERFECT_HASH_MAX_LEVELS 32
+
+/**
+ * @brief minimal perfect hash function for a fixed set of keys (BBHash like): every key is hashed into a bit array per level,
+ * keys that do not collide with other keys set their bit and keys that collide are passed to the next level. The value of a key 
+ * is the rank of its bit over all levels, therefore the n keys get the values 0..n-1 without storing the keys.
+ * Keys that are not in the set get an arbitrary value (or -1), so a lookup must be verified.
+ **/
+class MinimalPerfectHash
+{
+    public:
+    MinimalPerfectHash() = default;
+    //keys must be unique
+    MinimalPerfectHash(std::vector<uint64_t> keys)
+    {
+        //bits per key in each level: more bits mean less collisions (less levels) but more memory
+        const double gamma = 2.0;
+        uint64_t rankOffset = 0;
+        for(int level = 0; (level < PERFECT_HASH_MAX_LEVELS) && !keys.empty(); ++level)
+        {
+            const uint64_t levelSize = MAX((uint64_t)64, (((uint64_t)(gamma * keys.size()) + 63) / 64) * 64);
+            std::vector<uint64_t> collisions(levelSize / 64, 0);
+            std::vector<uint64_t> bits(levelSize / 64, 0);
+            for(const uint64_t& key : keys)
+            {
+                const uint64_t pos = hash(key, level) % levelSize;
+                const uint64_t bit = 1ULL << (pos % 64);
+                if(bits[pos / 64] & bit){collisions[pos / 64] |= bit;}
+                bits[pos / 64] |= bit;
+            }
+            std::vector<uint64_t> collidingKeys;
+            for(const uint64_t& key : keys)
+            {
+                const uint64_t pos = hash(key, level) % levelSize;
+                if(collisions[pos / 64] & (1ULL << (pos % 64))){collidingKeys.push_back(key);}
+            }
+            perfectHashLevel newLevel;
+            newLevel.size = levelSize;
+            newLevel.rankOffset = rankOffset;
+            newLevel.words.resize(bits.size());
+            uint32_t rank = 0;
+            for(int word = 0; word < (int)bits.size(); ++word)
+            {
+                newLevel.words[word] = std::make_pair(bits[word] & ~collisions[word], rank);
+                rank += __builtin_popcountll(newLevel.words[word].first);
+            }
+            rankOffset += rank;
+            levels.push_back(newLevel);
+            keys = collidingKeys;
+        }
+        std::sort(keys.begin(), keys.end());
+        for(int keyIdx = 0; keyIdx < (int)keys.size(); ++keyIdx)
+        {
+            remainingKeys.push_back(std::make_pair(keys.at(keyIdx), rankOffset + keyIdx));
+        }
+    }
+
+    //value in 0..n-1 for keys of the set, an arbitrary value or -1 for other keys
+    int64_t operator()(const uint64_t& key) const
+    {
+        for(int level = 0; level < (int)levels.size(); ++level)
+        {
+            const perfectHashLevel& currentLevel = levels[level];
+            const uint64_t pos = hash(key, level) % currentLevel.size;
+            const std::pair<uint64_t, uint32_t>& word = currentLevel.words[pos / 64];
+            const uint64_t bit = 1ULL << (pos % 64);
+            if(word.first & bit)
+            {
+                return currentLevel.rankOffset + word.second + __builtin_popcountll(word.first & (bit - 1));
+            }
+        }
+        std::vector<std::pair<uint64_t, uint64_t> >::const_iterator remaining = 
+            std::lower_bound(remainingKeys.begin(), remainingKeys.end(), std::make_pair(key, (uint64_t)0));
+        if( (remaining != remainingKeys.end()) && (remaining->first == key) ){return remaining->second;}
+        return -1;
+    }
+
+    //number of levels with bit arrays (keys that collide in all of them are in the sorted list)
+    int level_number() const {return levels.size();}
+
+    private:
+    //bit array of one level: each word with the number of set bits before it in this level
+    struct perfectHashLevel
+    {
+        uint64_t size = 0;
+        uint64_t rankOffset = 0;
+        std::vector<std::pair<uint64_t, uint32_t> > words;
+    };
+
+    //different hash function per level (splitmix64 finalizer)
+    static uint64_t hash(uint64_t key, const int& level)
+    {
+        key += 0x9E3779B97F4A7C15ULL * (level + 1);
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+        return key ^ (key >> 31);
+    }
+
+    std::vector<perfectHashLevel> levels;
+    //keys that still collided in the last level with their value
+    std::vector<std::pair<uint64_t, uint64_t> > remainingKeys;
+};
+
+/**
+ * @brief exact lookup of a window in the patterns of one length: a minimal perfect hash of the packed patterns
+ * gives the only candidate, which is then compared to the window.
+ **/
+class ExactBarcodeIndex
+{
+    public:
+    //patternIdx: the indices of the patterns of this length in patterns
+    ExactBarcodeIndex(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& inLength)
+    : length(inLength)
+    {
+        //same pattern can be several times in the list: store it once with the number of occurences
+        std::vector<std::pair<uint64_t, int> > packedPatterns;
+        for(const int& idx : patternIdx)
+        {
+            //only patterns of ACGT are indexed (applicable checks this before the index is built)
+            uint64_t packed = 0;
+            if(!pack_kmer(patterns.at(idx), packed)){continue;}
+            packedPatterns.push_back(std::make_pair(packed, idx));
+        }
+        std::sort(packedPatterns.begin(), packedPatterns.end());
+
+        std::vector<uint64_t> keys;
+        for(int entryIdx = 0; entryIdx < (int)packedPatterns.size(); ++entryIdx)
+        {
+            if( (entryIdx == 0) || (packedPatterns.at(entryIdx).first != packedPatterns.at(entryIdx - 1).first) )
+            {
+                keys.push_back(packedPatterns.at(entryIdx).first);
+            }
+        }
+        perfectHash = MinimalPerfectHash(keys);
+
+        entries.resize(keys.size());
+        for(int entryIdx = 0; entryIdx < (int)packedPatterns.size(); ++entryIdx)
+        {
+            exactEntry& entry = entries.at(perfectHash(packedPatterns.at(entryIdx).first));
+            if(entry.number == 0)
+            {
+                entry.key = packedPatterns.at(entryIdx).first;
+                entry.patternIdx = packedPatterns.at(entryIdx).second;
+            }
+            ++entry.number;
+        }
+    }
+
+    //an index can be used for patterns of ACGT of up to 32 bases
+    static bool applicable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length)
+    {
+        if( (length > 32) || (length == 0) ){return false;}
+        for(const int& idx : patternIdx)
+        {
+            uint64_t packed;
+            if(!pack_kmer(patterns.at(idx), packed)){return false;}
+        }
+        return true;
+    }
+
+    //result of an exact match of the window to the patterns: bestCount is the number of equal patterns (0 if there is none),
+    //in this case the window has a score of at least one to all patterns of this length
+    void lookup(std::string_view window, laneAlignmentResult& result) const
+    {
+        result = laneAlignmentResult();
+        uint64_t packedWindow;
+        //windows shorter than the pattern or with other bases can not match exactly
+        if( ((int)window.length() != length) || !pack_kmer(window, packedWindow) ){return;}
+
+        const int64_t entryIdx = perfectHash(packedWindow);
+        if( (entryIdx < 0) || (entryIdx >= (int64_t)entries.size()) || (entries[entryIdx].key != packedWindow) ){return;}
+        result.bestScore = 0;
+        result.bestCount = entries[entryIdx].number;
+        result.bestIdx = entries[entryIdx].patternIdx;
+    }
+
+    private:
+    //a pattern (the first index if it is several times in the list) stored at the position of its hash
+    struct exactEntry
+    {
+        uint64_t key = 0;
+        int patternIdx = -1;
+        int number = 0;
+    };
+
+    int length;
+    MinimalPerfectHash perfectHash;
+    std::vector<exactEntry> entries;
+};
+typedef std::shared_ptr<const ExactBarcodeIndex> ExactBarcodeIndexPtr;
+
+/**
+ * @brief patterns of one length packed into one word each, to compute the Hamming distance of a window to all patterns
+ * with a XOR and a popcount per pattern (for rounds where reads have substitutions but no insertions or deletions)
+ **/
+class HammingBarcodeIndex
+{
+    public:
+    //patternIdx: the indices of the patterns of this length in patterns
+    HammingBarcodeIndex(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& inLength)
+    : length(inLength)
+    {
+        for(const int& idx : patternIdx)
+        {
+            uint64_t packed = 0;
+            if(!pack_kmer(patterns.at(idx), packed)){continue;}
+            patternIndices.push_back(idx);
+            packedPatterns.push_back(packed);
+        }
+    }
+
+    //patterns of ACGT of up to 32 bases can be packed
+    static bool applicable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length)
+    {
+        return ExactBarcodeIndex::applicable(patterns, patternIdx, length);
+    }
+
+    //best Hamming distance of the window to the patterns (like levenshtein_lanes only scores up to mismatches are reported),
+    //windows shorter than the patterns have no result. N in the window is a mismatch to every base
+    void lookup(std::string_view window, const int& mismatches, laneAlignmentResult& result) const
+    {
+        result = laneAlignmentResult();
+        if((int)window.length() < length){return;}
+
+        uint64_t packedWindow = 0;
+        uint64_t nMask = 0;
+        pack_kmer_with_n_mask(window, length, packedWindow, nMask);
+
+        result.bestScore = mismatches + 1;
+        for(int lane = 0; lane < (int)packedPatterns.size(); ++lane)
+        {
+            const int score = kmer_hamming_distance(packedWindow, packedPatterns[lane], nMask);
+            if(score > mismatches){continue;}
+            if(score < result.bestScore)
+            {
+                result.bestScore = score;
+                result.bestCount = 1;
+                result.bestIdx = patternIndices[lane];
+            }
+            else if(score == result.bestScore)
+            {
+                ++result.bestCount;
+            }
+        }
+    }
+
+    private:
+    int length;
+    std::vector<int> patternIndices; //index of every packed pattern in the original pattern vector (ascending)
+    std::vector<uint64_t> packedPatterns;
+};
+typedef std::shared_ptr<const HammingBarcodeIndex> HammingBarcodeIndexPtr;
+
+/**
+ * @brief hash table of packed sequences (open addressing with linear probing) where every key maps to a range of values.
+ * Built once from all (key, value) pairs, keys must not be 0 (e.g. length tagged keys).
+ **/
+template <typename Value>
+class PackedKeyTable
+{
+    public:
+    PackedKeyTable() = default;
+    //entries must be sorted by key: the values of one key are stored next to each other
+    PackedKeyTable(const std::vector<std::pair<uint64_t, Value> >& entries)
+    {
+        //at least twice as many slots as keys
+        int keyNumber = 0;
+        for(int entryIdx = 0; entryIdx < (int)entries.size(); ++entryIdx)
+        {
+            if( (entryIdx == 0) || (entries.at(entryIdx).first != entries.at(entryIdx - 1).first) ){++keyNumber;}
+        }
+        slotShift = 63;
+        while( (1ULL << (64 - slotShift)) < 2ULL * keyNumber ){--slotShift;}
+        slots.assign(1ULL << (64 - slotShift), tableSlot());
+
+        values.reserve(entries.size());
+        for(int entryIdx = 0; entryIdx < (int)entries.size(); ++entryIdx)
+        {
+            if( (entryIdx == 0) || (entries.at(entryIdx).first != entries.at(entryIdx - 1).first) )
+            {
+                tableSlot& slot = find_slot(entries.at(entryIdx).first);
+                slot.key = entries.at(entryIdx).first;
+                slot.start = entryIdx;
+            }
+            ++find_slot(entries.at(entryIdx).first).number;
+            values.push_back(entries.at(entryIdx).second);
+        }
+    }
+
+    //range of values of key (empty range if the key is not in the table)
+    std::pair<const Value*, const Value*> find(const uint64_t& key) const
+    {
+        const tableSlot& slot = find_slot(key);
+        return std::make_pair(values.data() + slot.start, values.data() + slot.start + slot.number);
+    }
+
+    private:
+    //a key and the range of its values (key 0 is an empty slot)
+    struct tableSlot
+    {
+        uint64_t key = 0;
+        uint32_t start = 0;
+        uint32_t number = 0;
+    };
+
+    //slot of key or the empty slot where it belongs (the top bits of the hashed key are the slot)
+    const tableSlot& find_slot(const uint64_t& key) const
+    {
+        uint64_t slotIdx = (key * 0x9E3779B97F4A7C15ULL) >> slotShift;
+        while( (slots[slotIdx].key != key) && (slots[slotIdx].key != 0) )
+        {
+            slotIdx = (slotIdx + 1) & (slots.size() - 1);
+        }
+        return slots[slotIdx];
+    }
+    tableSlot& find_slot(const uint64_t& key)
+    {
+        return const_cast<tableSlot&>(static_cast<const PackedKeyTable*>(this)->find_slot(key));
+    }
+
+    std::vector<tableSlot> slots = std::vector<tableSlot>(2);
+    int slotShift = 63;
+    std::vector<Value> values;
+};
+
+/**
+ * @brief hash index of all sequences within mismatches edits of the patterns of one length. Maps each of these sequences
+ * to the patterns it is close to (together with the edit distance), so that the best pattern for a read window is found by looking up
+ * the substrings of the window instead of aligning the window to every pattern.
+ **/
+class EditNeighbourhoodIndex
+{
+    public:
+    //patternIdx: the indices of the patterns of this length in patterns
+    EditNeighbourhoodIndex(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& inLength, const int& inMismatches)
+    : length(inLength), mismatches(inMismatches)
+    {
+        //all (sequence, pattern, distance) triples, sorted to store the patterns of one sequence next to each other
+        std::vector<std::pair<uint64_t, std::pair<int, uint8_t> > > entries;
+        for(const int& idx : patternIdx)
+        {
+            add_neighbourhood(patterns.at(idx), idx, entries);
+            if(entries.size() > NEIGHBOURHOOD_INDEX_MAX_ENTRIES)
+            {
+                complete = false;
+                return;
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        neighbourTable = PackedKeyTable<std::pair<int, uint8_t> >(entries);
+        complete = true;
+    }
+
+    //an index can be used for patterns of ACGT and a mismatch number within the limits
+    static bool applicable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length, const int& mismatches)
+    {
+        if( (mismatches > NEIGHBOURHOOD_INDEX_MAX_MISMATCHES) || (length + mismatches > 31) || (length <= mismatches) ){return false;}
+        for(const int& idx : patternIdx)
+        {
+            uint64_t packed;
+            if(!pack_kmer(patterns.at(idx), packed)){return false;}
+        }
+        return true;
+    }
+
+    //false if the index could not be built within the size limit
+    bool is_complete() const {return complete;}
+
+    //same result as levenshtein_lanes for the patterns of this index: a pattern maps to the window if a substring of the window
+    //is within mismatches edits of it (the unpunished deletions at the start and end of the sequence).
+    //Returns false if the window can not be looked up (e.g. contains an N), in this case the window must be aligned
+    bool lookup(std::string_view window, laneAlignmentResult& result) const
+    {
+        result = laneAlignmentResult();
+        result.bestScore = mismatches + 1;
+
+        uint64_t packedWindow;
+        if(!pack_kmer(window, packedWindow)){return false;}
+
+        //best distance per pattern over all substrings
+        constexpr int maxCandidates = 64;
+        std::pair<int, int> candidates[maxCandidates];
+        int candidateNumber = 0;
+
+        const int windowLength = window.length();
+        for(int subLength = MAX(0, length - mismatches); subLength <= MIN(windowLength, length + mismatches); ++subLength)
+        {
+            const uint64_t subMask = (subLength == 32) ? ~0ULL : ((1ULL << (2 * subLength)) - 1);
+            for(int subStart = 0; subStart + subLength <= windowLength; ++subStart)
+            {
+                const uint64_t key = length_tagged_key((packedWindow >> (2 * subStart)) & subMask, subLength);
+                const std::pair<const std::pair<int, uint8_t>*, const std::pair<int, uint8_t>*> range = neighbourTable.find(key);
+                for(const std::pair<int, uint8_t>* entryPtr = range.first; entryPtr != range.second; ++entryPtr)
+                {
+                    const std::pair<int, uint8_t>& entry = *entryPtr;
+                    int candidateIdx = 0;
+                    while( (candidateIdx < candidateNumber) && (candidates[candidateIdx].first != entry.first) ){++candidateIdx;}
+                    if(candidateIdx == candidateNumber)
+                    {
+                        if(candidateNumber == maxCandidates){return false;}
+                        candidates[candidateNumber++] = std::make_pair(entry.first, (int)entry.second);
+                    }
+                    else
+                    {
+                        candidates[candidateIdx].second = MIN(candidates[candidateIdx].second, (int)entry.second);
+                    }
+                }
+            }
+        }
+
+        for(int candidateIdx = 0; candidateIdx < candidateNumber; ++candidateIdx)
+        {
+            const int& score = candidates[candidateIdx].second;
+            if(score < result.bestScore)
+            {
+                result.bestScore = score;
+                result.bestCount = 1;
+                result.bestIdx = candidates[candidateIdx].first;
+            }
+            else if(score == result.bestScore)
+            {
+                ++result.bestCount;
+                result.bestIdx = MIN(result.bestIdx, candidates[candidateIdx].first);
+            }
+        }
+        return true;
+    }
+
+    private:
+
+    //all sequences within mismatches edits of pattern (breadth first, so the first time a sequence is found gives its edit distance)
+    void add_neighbourhood(const std::string& pattern, const int& idx, std::vector<std::pair<uint64_t, std::pair<int, uint8_t> > >& entries)
+    {
+        const char bases[4] = {'A', 'C', 'G', 'T'};
+        std::unordered_set<uint64_t> found;
+        std::vector<std::string> currentEdits = {pattern};
+        uint64_t packed = 0;
+        if(!pack_kmer(pattern, packed)){return;}
+        found.insert(length_tagged_key(packed, pattern.length()));
+        entries.push_back(std::make_pair(length_tagged_key(packed, pattern.length()), std::make_pair(idx, (uint8_t)0)));
+
+        for(int distance = 1; distance <= mismatches; ++distance)
+        {
+            std::vector<std::string> nextEdits;
+            auto add_sequence = [&](const std::string& seq)
+            {
+                uint64_t packedSeq = 0;
+                if(!pack_kmer(seq, packedSeq)){return;}
+                const uint64_t key = length_tagged_key(packedSeq, seq.length());
+                if(found.insert(key).second)
+                {
+                    entries.push_back(std::make_pair(key, std::make_pair(idx, (uint8_t)distance)));
+                    nextEdits.push_back(seq);
+                }
+            };
+            for(const std::string& seq : currentEdits)
+            {
+                for(int pos = 0; pos <= (int)seq.length(); ++pos)
+                {
+                    for(const char& base : bases)
+                    {
+                        //insertion
+                        std::string inserted = seq;
+                        inserted.insert(inserted.begin() + pos, base);
+                        add_sequence(inserted);
+                        //substitution
+                        if( (pos < (int)seq.length()) && (seq[pos] != base) )
+                        {
+                            std::string substituted = seq;
+                            substituted[pos] = base;
+                            add_sequence(substituted);
+                        }
+                    }
+                    //deletion
+                    if(pos < (int)seq.length())
+                    {
+                        std::string deleted = seq;
+                        deleted.erase(pos, 1);
+                        add_sequence(deleted);
+                    }
+                }
+            }
+            currentEdits = nextEdits;
+        }
+    }
+
+    int length;
+    int mismatches;
+    bool complete = false;
+    //all sequences of the neighbourhood with the patterns they are close to: pattern index and edit distance
+    PackedKeyTable<std::pair<int, uint8_t> > neighbourTable;
+};
+typedef std::shared_ptr<const EditNeighbourhoodIndex> EditNeighbourhoodIndexPtr;
+
+//build an index for every group of patterns of one length (nullptr where no index can be used)
+inline std::vector<EditNeighbourhoodIndexPtr> generate_neighbourhood_indexes(const std::vector<std::string>& patterns,
+                                                                             const std::vector<patternLanes>& laneGroups, const int& mismatches)
+{
+    std::vector<EditNeighbourhoodIndexPtr> indexes;
+    for(const patternLanes& lanes : laneGroups)
+    {
+        EditNeighbourhoodIndexPtr index = nullptr;
+        if(EditNeighbourhoodIndex::applicable(patterns, lanes.patternIdx, lanes.length, mismatches))
+        {
+            std::shared_ptr<EditNeighbourhoodIndex> newIndex = std::make_shared<EditNeighbourhoodIndex>(patterns, lanes.patternIdx, lanes.length, mismatches);
+            if(newIndex->is_complete()){index = newIndex;}
+        }
+        indexes.push_back(index);
+    }
+    return indexes;
+}
+
+//seed indexes are only used for large groups of patterns, for smaller groups the alignment to all patterns is fast enough
+#define SEED_INDEX_MIN_PATTERNS 1024
+//same for the trie of patterns
+#define PATTERN_TRIE_MIN_PATTERNS 1024
+
+/**
+ * @brief q-gram index of the patterns of one length to find candidates for approximate matching in large lists of patterns (pigeonhole principle):
+ * every pattern is split into mismatches+1 seeds and at least one of them occurs unchanged in a window that is within mismatches edits of the pattern 
+ * (shifted by at most mismatches bases). Only the patterns with a seed in the window are aligned.
+ **/
+class SeedCandidateIndex
+{
+    public:
+    //patternIdx: the indices of the patterns of this length in patterns
+    SeedCandidateIndex(const std::vector<std::string>& patterns, const std::vector<int>& inPatternIdx, const int& inLength, const int& inMismatches)
+    : patternIdx(inPatternIdx), length(inLength), mismatches(inMismatches)
+    {
+        for(const int& idx : patternIdx){groupBases.append(patterns.at(idx));}
+
+        const int seedNumber = mismatches + 1;
+        for(int seed = 0; seed < seedNumber; ++seed)
+        {
+            //seeds longer than one key are shortened, a part of a seed also occurs unchanged
+            seedStarts.push_back(seed * length / seedNumber);
+            seedLengths.push_back(MIN(31, (seed + 1) * length / seedNumber - seedStarts.back()));
+
+            std::vector<std::pair<uint64_t, int> > entries;
+            for(int groupIdx = 0; groupIdx < (int)patternIdx.size(); ++groupIdx)
+            {
+                uint64_t packed = 0;
+                if(!pack_kmer(group_pattern(groupIdx).substr(seedStarts.back(), seedLengths.back()), packed)){continue;}
+                entries.push_back(std::make_pair(length_tagged_key(packed, seedLengths.back()), groupIdx));
+            }
+            std::sort(entries.begin(), entries.end());
+            seedTables.push_back(PackedKeyTable<int>(entries));
+        }
+    }
+
+    //an index can be used for many patterns of ACGT if the seeds are long enough to select only few of them
+    static bool applicable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length, const int& mismatches)
+    {
+        if( (patternIdx.size() < SEED_INDEX_MIN_PATTERNS) || (mismatches == 0) || (length <= mismatches) ){return false;}
+        //a seed is searched at 2*mismatches+1 positions in the window: aligning a candidate costs about as much as 
+        //aligning 64 patterns in SIMD lanes, therefore on average less than 1/64 of the patterns should be a candidate
+        const int shortestSeed = MIN(31, length / (mismatches + 1));
+        if( (mismatches + 1) * (2 * mismatches + 1) * 64.0 >= std::pow(4.0, shortestSeed) ){return false;}
+        for(const int& idx : patternIdx)
+        {
+            for(const char& base : patterns.at(idx))
+            {
+                if(nucleotides.code[(unsigned char)base] > 3){return false;}
+            }
+        }
+        return true;
+    }
+
+    //same result as levenshtein_lanes for the patterns of this index: only the candidates are aligned to the window
+    void lookup(std::string_view window, laneAlignmentResult& result) const
+    {
+        result = laneAlignmentResult();
+        result.bestScore = mismatches + 1;
+
+        //candidates of all seeds, every candidate is aligned once
+        static thread_local std::vector<int> candidates;
+        candidates.clear();
+        for(int seed = 0; seed < (int)seedTables.size(); ++seed)
+        {
+            for(int seedStart = MAX(0, seedStarts.at(seed) - mismatches); seedStart <= seedStarts.at(seed) + mismatches; ++seedStart)
+            {
+                if(seedStart + seedLengths.at(seed) > (int)window.length()){break;}
+                uint64_t packed;
+                if(!pack_kmer(window.substr(seedStart, seedLengths.at(seed)), packed)){continue;}
+                const std::pair<const int*, const int*> range = seedTables.at(seed).find(length_tagged_key(packed, seedLengths.at(seed)));
+                candidates.insert(candidates.end(), range.first, range.second);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        for(const int& groupIdx : candidates)
+        {
+            int score;
+            if(!levenshtein_score(window, group_pattern(groupIdx), mismatches, score, true)){continue;}
+            if(score < result.bestScore)
+            {
+                result.bestScore = score;
+                result.bestCount = 1;
+                result.bestIdx = patternIdx[groupIdx];
+            }
+            else if(score == result.bestScore)
+            {
+                ++result.bestCount;
+                result.bestIdx = MIN(result.bestIdx, patternIdx[groupIdx]);
+            }
+        }
+    }
+
+    private:
+    std::string_view group_pattern(const int& groupIdx) const
+    {
+        return std::string_view(groupBases).substr(groupIdx * length, length);
+    }
+
+    std::vector<int> patternIdx;
+    //all patterns of the group one after the other
+    std::string groupBases;
+    int length;
+    int mismatches;
+    //position and length of the seeds in the patterns, each with a table of the patterns (index in the group) per seed sequence
+    std::vector<int> seedStarts;
+    std::vector<int> seedLengths;
+    std::vector<PackedKeyTable<int> > seedTables;
+};
+typedef std::shared_ptr<const SeedCandidateIndex> SeedCandidateIndexPtr;
+
+//universal Levenshtein automata are built for up to this many mismatches (the number of states grows fast with the mismatches)
+#define LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES 2
+
+/**
+ * @brief universal Levenshtein automaton (Schulz and Mihov) for the alignment of a window to a pattern that is read base by base:
+ * a state is the band of the DP column around the diagonal (2*mismatches+1 cells, all values above mismatches are the same) and the 
+ * transition for the next base of the pattern only depends on the characteristic vector of the band: which cells are a match, a mismatch,
+ * the first row or outside of the window. The automaton does not depend on the window or the patterns, its tables are built once per mismatches.
+ **/
+class LevenshteinAutomaton
+{
+    public:
+    //class of one cell of the band in the characteristic vector (2 bits per cell, first cell in the lowest bits)
+    enum cellClass {MISMATCH_CELL = 0, MATCH_CELL = 1, FIRST_ROW_CELL = 2, OUTSIDE_CELL = 3};
+
+    LevenshteinAutomaton(const int& inMismatches) : mismatches(inMismatches), width(2 * inMismatches + 1), vectorNumber(1 << (2 * width))
+    {
+        int codeNumber = 1;
+        for(int cell = 0; cell < width; ++cell){codeNumber *= mismatches + 2;}
+        stateIndices.assign(codeNumber, -1);
+
+        //initial states: band of the root column around row 0, rows of the window are zero (unpunished deletions at the start)
+        for(int windowLength = 0; windowLength <= mismatches; ++windowLength)
+        {
+            std::vector<uint8_t> values(width, mismatches + 1);
+            for(int cell = mismatches; cell <= mismatches + windowLength; ++cell){values.at(cell) = 0;}
+            initialStates.push_back(add_state(values));
+        }
+        //transitions of all states, new states are added at the end and get their transitions later on
+        for(int state = 0; state < (int)stateMinimum.size(); ++state)
+        {
+            std::vector<uint8_t> values(width);
+            for(int vector = 0; vector < vectorNumber; ++vector)
+            {
+                next_values(state, vector, 1, values.data());
+                transitions.push_back(add_state(values));
+            }
+        }
+    }
+
+    //the automaton of mismatches, built once and shared by all threads
+    static const LevenshteinAutomaton& get(const int& mismatches)
+    {
+        assert(mismatches <= LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES);
+        static const LevenshteinAutomaton automata[LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES + 1] = {LevenshteinAutomaton(0), LevenshteinAutomaton(1), 
+                                                                                                LevenshteinAutomaton(2)};
+        return automata[mismatches];
+    }
+
+    int initial_state(const int& windowLength) const {return initialStates[MIN(windowLength, mismatches)];}
+    int next_state(const int& state, const int& vector) const {return transitions[state * vectorNumber + vector];}
+    //smallest value of the band (mismatches+1 if all values are above mismatches)
+    int minimum(const int& state) const {return stateMinimum[state];}
+    //value of one cell of the last column, where deletions are not punished (unpunished deletions at the end of the window)
+    int last_column_value(const int& state, const int& vector, const int& cell) const
+    {
+        uint8_t values[2 * LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES + 1];
+        next_values(state, vector, 0, values);
+        return values[cell];
+    }
+
+    //characteristic vector for a base of the pattern at depth (1-based in the pattern)
+    int characteristic_vector(std::string_view window, const int& depth, const char& base) const
+    {
+        int vector = 0;
+        for(int cell = 0; cell < width; ++cell)
+        {
+            vector |= cell_class(window, depth - mismatches + cell, base) << (2 * cell);
+        }
+        return vector;
+    }
+    //same vector for the next depth: the band moves one row down
+    int next_characteristic_vector(const int& vector, std::string_view window, const int& depth, const char& base) const
+    {
+        return (vector >> 2) | (cell_class(window, depth + mismatches, base) << (2 * (width - 1)));
+    }
+
+    private:
+    static int cell_class(std::string_view window, const int& row, const char& base)
+    {
+        if( (row < 0) || (row > (int)window.length()) ){return OUTSIDE_CELL;}
+        if(row == 0){return FIRST_ROW_CELL;}
+        return (window[row - 1] == base) ? MATCH_CELL : MISMATCH_CELL;
+    }
+
+    //band of the next column: the cell of the same row in the previous column is one cell to the right in the band
+    void next_values(const int& state, const int& vector, const int& deletion, uint8_t* values) const
+    {
+        const uint8_t* previous = stateValues.data() + state * width;
+        for(int cell = 0; cell < width; ++cell)
+        {
+            const int cellType = (vector >> (2 * cell)) & 3;
+            int value = mismatches + 1;
+            if(cellType == FIRST_ROW_CELL)
+            {
+                //the first row contains the depth, which is mismatches-cell for the cell in the first row
+                value = MAX(0, mismatches - cell);
+            }
+            else if(cellType != OUTSIDE_CELL)
+            {
+                value = previous[cell] + ((cellType == MATCH_CELL) ? 0 : 1);
+                if(cell + 1 < width){value = MIN(value, previous[cell + 1] + 1);}
+                if(cell > 0){value = MIN(value, values[cell - 1] + deletion);}
+            }
+            values[cell] = MIN(value, mismatches + 1);
+        }
+    }
+
+    //index of the state with these values (new states are added)
+    int add_state(const std::vector<uint8_t>& values)
+    {
+        int code = 0;
+        for(const uint8_t& value : values){code = code * (mismatches + 2) + value;}
+        if(stateIndices.at(code) >= 0){return stateIndices.at(code);}
+
+        stateIndices.at(code) = stateMinimum.size();
+        stateValues.insert(stateValues.end(), values.begin(), values.end());
+        stateMinimum.push_back(*std::min_element(values.begin(), values.end()));
+        return stateMinimum.size() - 1;
+    }
+
+    int mismatches;
+    int width;
+    int vectorNumber;
+    std::vector<int> initialStates;
+    //values of the band and their minimum per state
+    std::vector<uint8_t> stateValues;
+    std::vector<uint8_t> stateMinimum;
+    //next state for every state and characteristic vector
+    std::vector<uint16_t> transitions;
+    //state of the values of a band (as number with base mismatches+2), -1 if the state does not exist
+    std::vector<int> stateIndices;
+};
+
+/**
+ * @brief trie of the patterns of one length to align a window to all patterns at once: the DP column of a pattern prefix is computed
+ * once for all patterns sharing this prefix, and a subtree is skipped as soon as all cells of the column are above the mismatches 
+ * (or above the best score found so far), since the values of a column never decrease along the path to the leaves.
+ **/
+class PatternTrie
+{
+    public:
+    //patternIdx: the indices of the patterns of this length in patterns
+    PatternTrie(const std::vector<std::string>& patterns, const std::vector<int>& inPatternIdx, const int& inLength, const int& inMismatches)
+    : length(inLength), mismatches(inMismatches)
+    {
+        nodes.push_back(trieNode());
+        //patterns in each leaf in order of their index
+        std::vector<std::vector<int> > nodePatterns(1);
+        for(const int& idx : inPatternIdx)
+        {
+            int nodeIdx = 0;
+            for(const char& base : patterns.at(idx))
+            {
+                const int code = nucleotides.code[(unsigned char)base];
+                if(nodes.at(nodeIdx).children[code] < 0)
+                {
+                    nodes.at(nodeIdx).children[code] = nodes.size();
+                    nodes.push_back(trieNode());
+                    nodePatterns.push_back(std::vector<int>());
+                }
+                nodeIdx = nodes.at(nodeIdx).children[code];
+            }
+            nodePatterns.at(nodeIdx).push_back(idx);
+        }
+        for(int nodeIdx = 0; nodeIdx < (int)nodes.size(); ++nodeIdx)
+        {
+            nodes.at(nodeIdx).patternStart = patternIdx.size();
+            nodes.at(nodeIdx).patternNumber = nodePatterns.at(nodeIdx).size();
+            patternIdx.insert(patternIdx.end(), nodePatterns.at(nodeIdx).begin(), nodePatterns.at(nodeIdx).end());
+        }
+    }
+
+    //a trie can be built for patterns of ACGT
+    static bool searchable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length, const int& mismatches)
+    {
+        if(length <= mismatches){return false;}
+        for(const int& idx : patternIdx)
+        {
+            for(const char& base : patterns.at(idx))
+            {
+                if(nucleotides.code[(unsigned char)base] > 3){return false;}
+            }
+        }
+        return true;
+    }
+    //a trie is used for many patterns of ACGT
+    static bool applicable(const std::vector<std::string>& patterns, const std::vector<int>& patternIdx, const int& length, const int& mismatches)
+    {
+        return (patternIdx.size() >= PATTERN_TRIE_MIN_PATTERNS) && searchable(patterns, patternIdx, length, mismatches);
+    }
+
+    //same result as levenshtein_lanes for the patterns of this trie
+    void lookup(std::string_view window, laneAlignmentResult& result) const
+    {
+        search(window, result);
+    }
+
+    //average number of DP columns computed per window for a sample of windows: mostly patterns with one substitution 
+    //(the usual case of a read) and some random sequences (reads of other origin), as estimate of the cost of a lookup
+    double sample_columns(const std::vector<std::string>& patterns, const std::vector<int>& groupIdx) const
+    {
+        const int sampleNumber = 64;
+        std::mt19937 generator(0);
+        long long columnNumber = 0;
+        for(int sample = 0; sample < sampleNumber; ++sample)
+        {
+            std::string window = patterns.at(groupIdx.at(generator() % groupIdx.size()));
+            if(sample % 4 == 0)
+            {
+                for(char& base : window){base = nucleotides.base[generator() % 4];}
+            }
+            else
+            {
+                window[generator() % length] = nucleotides.base[generator() % 4];
+            }
+            laneAlignmentResult result;
+            columnNumber += search(window, result);
+        }
+        return columnNumber / (double)sampleNumber;
+    }
+
+    private:
+    struct trieNode
+    {
+        int children[4] = {-1, -1, -1, -1};
+        //patterns ending in this node (only in leaves)
+        int patternStart = 0;
+        int patternNumber = 0;
+    };
+
+    //search of the best patterns for the window, returns the number of computed columns
+    int search(std::string_view window, laneAlignmentResult& result) const
+    {
+        result = laneAlignmentResult();
+        result.bestScore = mismatches + 1;
+
+        //If the window is not longer than the patterns, alignments within mismatches stay within the diagonals +/- mismatches:
+        //only this band of each column is needed, and for few mismatches the universal Levenshtein automaton gives the next band
+        //for every base of the trie from one table lookup
+        if( ((int)window.length() <= length) && (mismatches <= LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES) )
+        {
+            const LevenshteinAutomaton& automaton = LevenshteinAutomaton::get(mismatches);
+            //characteristic vectors for each base at every depth
+            static thread_local std::vector<int> vectors;
+            vectors.resize(4 * (length + 1));
+            for(int code = 0; code < 4; ++code)
+            {
+                vectors[4 + code] = automaton.characteristic_vector(window, 1, nucleotides.base[code]);
+                for(int depth = 2; depth <= length; ++depth)
+                {
+                    vectors[4 * depth + code] = automaton.next_characteristic_vector(vectors[4 * (depth - 1) + code], window, depth, nucleotides.base[code]);
+                }
+            }
+            //the score of a pattern is in the cell of the last row of the window in the last column
+            const int lastCell = window.length() - length + mismatches;
+            return search_automaton(0, 0, automaton.initial_state(window.length()), automaton, window, vectors.data(), lastCell, result);
+        }
+
+        //one column per depth of the trie: column[i] is the distance of the first i bases of the window to the prefix,
+        //the column of the root is zero (unpunished deletions at the start of the window).
+        //Only the band is filled and all other cells keep a value above every possible score
+        const int rows = window.length() + 1;
+        const int band = ((int)window.length() <= length) ? mismatches : rows + length;
+        static thread_local std::vector<int> columns;
+        columns.assign((length + 1) * rows, rows + length + 1);
+        for(int i = 0; i <= MIN(band, rows - 1); ++i){columns[i] = 0;}
+        return search_children(0, 0, window, band, columns.data(), result);
+    }
+
+    //same as search_children with states of the Levenshtein automaton instead of DP columns
+    int search_automaton(const int& nodeIdx, const int& depth, const int& state, const LevenshteinAutomaton& automaton, std::string_view window, 
+                         const int* vectors, const int& lastCell, laneAlignmentResult& result) const
+    {
+        int columnNumber = 0;
+        const int firstCode = (depth < (int)window.length()) ? nucleotides.code[(unsigned char)window[depth]] & 3 : 0;
+        for(int codeIdx = 0; codeIdx < 4; ++codeIdx)
+        {
+            const int code = (firstCode + codeIdx) & 3;
+            const int childIdx = nodes[nodeIdx].children[code];
+            if(childIdx < 0){continue;}
+
+            ++columnNumber;
+            const int vector = vectors[4 * (depth + 1) + code];
+            const int limit = (result.bestCount == 0) ? mismatches : result.bestScore;
+            if(depth + 1 < length)
+            {
+                const int childState = automaton.next_state(state, vector);
+                if(automaton.minimum(childState) > limit){continue;}
+                columnNumber += search_automaton(childIdx, depth + 1, childState, automaton, window, vectors, lastCell, result);
+                continue;
+            }
+            if(lastCell < 0){continue;}
+            const int score = automaton.last_column_value(state, vector, lastCell);
+            if(score > limit){continue;}
+            add_leaf(nodes[childIdx], score, result);
+        }
+        return columnNumber;
+    }
+
+    //patterns of a leaf with a score within the limit
+    void add_leaf(const trieNode& leaf, const int& score, laneAlignmentResult& result) const
+    {
+        if(score < result.bestScore)
+        {
+            result.bestScore = score;
+            result.bestCount = 0;
+            result.bestIdx = patternIdx[leaf.patternStart];
+        }
+        result.bestCount += leaf.patternNumber;
+        result.bestIdx = MIN(result.bestIdx, patternIdx[leaf.patternStart]);
+    }
+
+    //returns the number of computed columns
+    int search_children(const int& nodeIdx, const int& depth, std::string_view window, const int& band, int* columns, laneAlignmentResult& result) const
+    {
+        int columnNumber = 0;
+        const int rows = window.length() + 1;
+        const int* parent = columns + depth * rows;
+        int* column = columns + (depth + 1) * rows;
+        const int firstRow = MAX(0, depth + 1 - band);
+        const int lastRow = MIN(rows - 1, depth + 1 + band);
+        //in the last column deletions are not punished (unpunished deletions at the end of the window)
+        const int deletion = (depth + 1 == length) ? 0 : 1;
+        //the child with the base of the window at this position first: a good score found early prunes more subtrees
+        const int firstCode = (depth < (int)window.length()) ? nucleotides.code[(unsigned char)window[depth]] & 3 : 0;
+        for(int codeIdx = 0; codeIdx < 4; ++codeIdx)
+        {
+            const int code = (firstCode + codeIdx) & 3;
+            const int childIdx = nodes[nodeIdx].children[code];
+            if(childIdx < 0){continue;}
+
+            const char base = nucleotides.base[code];
+            ++columnNumber;
+            int columnMinimum = INT_MAX;
+            if(firstRow == 0)
+            {
+                column[0] = depth + 1;
+                columnMinimum = column[0];
+            }
+            for(int i = MAX(1, firstRow); i <= lastRow; ++i)
+            {
+                column[i] = MIN(MIN(parent[i-1] + ((window[i-1] == base) ? 0 : 1), parent[i] + 1), column[i-1] + deletion);
+                columnMinimum = MIN(columnMinimum, column[i]);
+            }
+            //ties with the best score must still be counted
+            const int limit = (result.bestCount == 0) ? mismatches : result.bestScore;
+            if(columnMinimum > limit){continue;}
+
+            if(depth + 1 < length)
+            {
+                columnNumber += search_children(childIdx, depth + 1, window, band, columns, result);
+                continue;
+            }
+            const int score = column[rows - 1];
+            if(score > limit){continue;}
+            add_leaf(nodes[childIdx], score, result);
+        }
+        return columnNumber;
+    }
+
+    int length;
+    int mismatches;
+    std::vector<trieNode> nodes;
+    //pattern indices of all leaves
+    std::vector<int> patternIdx;
+};
+typedef std::shared_ptr<const PatternTrie> PatternTriePtr;
+
+//build an exact index for every group of patterns of one length (nullptr where no index can be used)
+inline std::vector<ExactBarcodeIndexPtr> generate_exact_indexes(const std::vector<std::string>& patterns, const std::vector<patternLanes>& laneGroups)
+{
+    std::vector<ExactBarcodeIndexPtr> indexes;
+    for(const patternLanes& lanes : laneGroups)
+    {
+        ExactBarcodeIndexPtr index = nullptr;
+        if(ExactBarcodeIndex::applicable(patterns, lanes.patternIdx, lanes.length))
+        {
+            index = std::make_shared<const ExactBarcodeIndex>(patterns, lanes.patternIdx, lanes.length);
+        }
+        indexes.push_back(index);
+    }
+    return indexes;
+}
+
+//build a Hamming index for every group of patterns of one length, returns an empty vector if not all groups can be packed
+inline std::vector<HammingBarcodeIndexPtr> generate_hamming_indexes(const std::vector<std::string>& patterns, const std::vector<patternLanes>& laneGroups)
+{
+    std::vector<HammingBarcodeIndexPtr> indexes;
+    for(const patternLanes& lanes : laneGroups)
+    {
+        if(!HammingBarcodeIndex::applicable(patterns, lanes.patternIdx, lanes.length)){return std::vector<HammingBarcodeIndexPtr>();}
+        indexes.push_back(std::make_shared<const HammingBarcodeIndex>(patterns, lanes.patternIdx, lanes.length));
+    }
+    return indexes;
+}
+
+//build a seed index for every group of patterns of one length that has no index of its edit-neighbourhood (nullptr where no index can be used)
+inline std::vector<SeedCandidateIndexPtr> generate_seed_indexes(const std::vector<std::string>& patterns, const std::vector<patternLanes>& laneGroups,
+                                                                const std::vector<EditNeighbourhoodIndexPtr>& neighbourhoodIndexes, const int& mismatches)
+{
+    std::vector<SeedCandidateIndexPtr> indexes;
+    for(int groupIdx = 0; groupIdx < (int)laneGroups.size(); ++groupIdx)
+    {
+        const patternLanes& lanes = laneGroups.at(groupIdx);
+        SeedCandidateIndexPtr index = nullptr;
+        if( (neighbourhoodIndexes.at(groupIdx) == nullptr) && SeedCandidateIndex::applicable(patterns, lanes.patternIdx, lanes.length, mismatches) )
+        {
+            index = std::make_shared<const SeedCandidateIndex>(patterns, lanes.patternIdx, lanes.length, mismatches);
+        }
+        indexes.push_back(index);
+    }
+    return indexes;
+}
+
+//build a trie for every group of patterns of one length that has no other index (nullptr where no trie can be used)
+inline std::vector<PatternTriePtr> generate_pattern_tries(const std::vector<std::string>& patterns, const std::vector<patternLanes>& laneGroups,
+                                                          const std::vector<EditNeighbourhoodIndexPtr>& neighbourhoodIndexes, 
+                                                          const std::vector<SeedCandidateIndexPtr>& seedIndexes, const int& mismatches)
+{
+    std::vector<PatternTriePtr> tries;
+    for(int groupIdx = 0; groupIdx < (int)laneGroups.size(); ++groupIdx)
+    {
+        const patternLanes& lanes = laneGroups.at(groupIdx);
+        PatternTriePtr trie = nullptr;
+        if( (neighbourhoodIndexes.at(groupIdx) == nullptr) && (seedIndexes.at(groupIdx) == nullptr) && 
+            PatternTrie::applicable(patterns, lanes.patternIdx, lanes.length, mismatches) )
+        {
+            trie = std::make_shared<const PatternTrie>(patterns, lanes.patternIdx, lanes.length, mismatches);
+            //the trie is only used if it is cheaper than the SIMD lanes: a column costs about as much as 
+            //200 bases in the specialised lane kernels and 25 bases in the generic kernels
+            const double laneBasesPerColumn = (lanes.fixedKernel != nullptr) ? 200.0 : 25.0;
+            if(trie->sample_columns(patterns, lanes.patternIdx) * laneBasesPerColumn >= (double)lanes.patternIdx.size() * lanes.length)
+            {
+                trie = nullptr;
+            }
+        }
+        tries.push_back(trie);
+    }
+    return tries;
+}
+
+//build a trie for every group of patterns of one length to match all windows with the Levenshtein automaton (independent of the number 
+//of patterns and other indexes), returns an empty vector if not all groups can be searched like this
+inline std::vector<PatternTriePtr> generate_automaton_tries(const std::vector<std::string>& patterns, const std::vector<patternLanes>& laneGroups,
+                                                            const int& mismatches)
+{
+    std::vector<PatternTriePtr> tries;
+    if(mismatches > LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES){return tries;}
+    for(const patternLanes& lanes : laneGroups)
+    {
+        if(!PatternTrie::searchable(patterns, lanes.patternIdx, lanes.length, mismatches)){return std::vector<PatternTriePtr>();}
+        tries.push_back(std::make_shared<const PatternTrie>(patterns, lanes.patternIdx, lanes.length, mismatches));
+    }
+    return tries;
+}
@@ -11,6 +11,68 @@ bool check_if_seq_too_short(const int& offset, const std::string& seq)
     return false;
 }
 
+//exact match of a barcode at the shifts of the offset model, the result is relative to offset like in match_pattern. Only shifts that match_pattern
+//reaches as well are tried: up to differenceInBarcodeLength windows plus mismatches behind the offset, and in front of it at most mismatches bases
+//if a wildcard is in front (start correction). The hit is only taken if the barcode matches exactly at one of these shifts and at no other.
+//Unlike a search that stops at the first perfect hit in order of frequency, all (at most OFFSET_MODEL_MAX_TRIES) shifts are tried, and
+//the search only stops early at a second hit: this is deliberate, a barcode that is exact at two shifts (e.g. in a repetitive read) is
+//ambiguous and left to the alignment instead of being decided by the order of the learned shifts.
+//This changes the result compared to match_pattern, which takes the first window with a hit within the mismatches: an exact hit at a learned
+//shift is preferred over an approximate hit closer to the offset (e.g. AAAAAAAC one base behind the offset instead of AAAAAAA with a deletion)
+bool match_learned_offsets(const barcodePlan& plan, const int& round, const barcodePlanStep& step, std::string_view seq, const int& offset,
+                           const bool& startCorrection, const bool& reverse, matchResult& match)
+{
+    if( (plan.offsetModel == nullptr) || !plan.offsetModel->is_learned() ){return false;}
+    const int minShift = startCorrection ? -step.mismatches : 0;
+    const int maxShift = MAX(0, match.differenceInBarcodeLength) + step.mismatches;
+    matchResult hit;
+    int hitShift = 0;
+    bool found = false;
+    for(const int& shift : plan.offsetModel->shifts(round))
+    {
+        if( (shift < minShift) || (shift > maxShift) || (offset + shift < 0) || (offset + shift >= (int)seq.length()) ){continue;}
+        matchResult shiftedMatch;
+        if(step.barcode->match_exact(seq, offset + shift, shiftedMatch, reverse))
+        {
+            //exact hits at several learned shifts: the read is aligned like without learned offsets
+            if(found){return false;}
+            found = true;
+            hit = shiftedMatch;
+            hitShift = shift;
+        }
+    }
+    if(!found){return false;}
+    match = hit;
+    match.seq_start += hitShift;
+    match.seq_end += hitShift;
+    return true;
+}
+
+//check before mapping a read if it can map at all: every constant barcode in front of a stop must be within its mismatches somewhere in the read
+//(a read that misses one fails in the sequential mapping anyway). Constant barcodes are checked longest first, exactly at their position if it
+//is fixed, otherwise they are searched from there on (and in front of it only if they are not found behind)
+bool constant_barcodes_present(const barcodePlan& plan, std::string_view seq)
+{
+    for(const int& stepIdx : plan.precheckOrder)
+    {
+        const barcodePlanStep& step = plan.steps[stepIdx];
+        if( (step.nominalOffset >= 0) && (step.nominalOffset + step.length <= (int)seq.length()) && 
+            (std::memcmp(seq.data() + step.nominalOffset, step.pattern.data(), step.length) == 0) )
+        {
+            continue;
+        }
+        //a hit starting in front of searchStart ends at most length + mismatches bases later
+        const int searchStart = MIN((int)seq.length(), MAX(0, step.nominalOffset - step.mismatches));
+        if(!plan.anchorSearch->contains(seq.substr(searchStart), step.anchorIdx, step.mismatches) && 
+           ( (searchStart == 0) || 
+             !plan.anchorSearch->contains(seq.substr(0, searchStart + step.length + step.mismatches), step.anchorIdx, step.mismatches) ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 //initialize the dictionary of mismatches in each specific barcode
 // the vector in the dict has length "mismatches + 2" for each barcode
 // one entry for zero mismatches, eveery number from, 1 to mismatches and 
@@ -34,7 +96,8 @@ void Mapping<MappingPolicy, FilePolicy>::initializeStats()
 
 template <typename MappingPolicy, typename FilePolicy>
 void Mapping<MappingPolicy, FilePolicy>::parse_barcode_data(const input& input, std::vector<std::pair<std::string, char> >& patterns, 
-                                                            std::vector<int>& mismatches, std::vector<std::vector<std::string> >& varyingBarcodes)
+                                                            std::vector<int>& mismatches, std::vector<matchingMode>& matchingModes,
+                                                            std::vector<std::vector<std::string> >& varyingBarcodes)
 {
     try{
         // parse the pattern, mismatches, and barcode file (perform quality check as well)
@@ -91,19 +154,50 @@ void Mapping<MappingPolicy, FilePolicy>::parse_barcode_data(const input& input,
         pattern = input.mismatchLine;
         delimiter = ",";
         pos = 0;
+        std::vector<std::string> mismatchEntries;
         while ((pos = pattern.find(delimiter)) != std::string::npos) 
         {
             seq = pattern.substr(0, pos);
             pattern.erase(0, pos + 1);
-            mismatches.push_back(stoi(seq));
+            mismatchEntries.push_back(seq);
+        }
+        mismatchEntries.push_back(pattern);
+        //mismatches with a leading h (e.g. h1) are only substitutions, matched with the Hamming distance,
+        //with a leading a (e.g. a1) the barcode is matched with the Levenshtein automaton
+        for(std::string mismatchEntry : mismatchEntries)
+        {
+            matchingMode mode = matchingMode::EDIT_DISTANCE;
+            if(!mismatchEntry.empty() && mismatchEntry.at(0) == 'h'){mode = matchingMode::HAMMING;}
+            else if(!mismatchEntry.empty() && mismatchEntry.at(0) == 'a'){mode = matchingMode::LEVENSHTEIN_AUTOMATON;}
+            if(mode != matchingMode::EDIT_DISTANCE){mismatchEntry.erase(0, 1);}
+            mismatches.push_back(stoi(mismatchEntry));
+            matchingModes.push_back(mode);
         }
-        mismatches.push_back(stoi(pattern));
 
         if(patterns.size() != mismatches.size())
         {
             std::cerr << "PARAMETER ERROR: Number of barcode patterns and mismatches is not equal\n";
             exit(1);
         }
+        for(int i = 0; i < (int)patterns.size(); ++i)
+        {
+            if( (matchingModes.at(i) == matchingMode::HAMMING) && (patterns.at(i).second != 'v') )
+            {
+                std::cerr << "PARAMETER ERROR: Hamming matching (mismatches starting with h) is only possible for variable barcodes ([NNN...])\n";
+                exit(1);
+            }
+            if( (matchingModes.at(i) == matchingMode::LEVENSHTEIN_AUTOMATON) && (patterns.at(i).second != 'v') )
+            {
+                std::cerr << "PARAMETER ERROR: Levenshtein automaton matching (mismatches starting with a) is only possible for variable barcodes ([NNN...])\n";
+                exit(1);
+            }
+            if( (matchingModes.at(i) == matchingMode::LEVENSHTEIN_AUTOMATON) && (mismatches.at(i) > LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES) )
+            {
+                std::cerr << "PARAMETER ERROR: Levenshtein automaton matching (mismatches starting with a) is only possible for up to " 
+                          << std::to_string(LEVENSHTEIN_AUTOMATON_MAX_MISMATCHES) << " mismatches\n";
+                exit(1);
+            }
+        }
         //PARSE barcode file
         std::ifstream barcodeFile(input.barcodeFile);
         for(std::string line; std::getline(barcodeFile, line);)
@@ -223,10 +317,11 @@ std::vector<std::pair<std::string, char> > Mapping<MappingPolicy, FilePolicy>::g
                                                         //second entry is c=constant, v=varying, w=wildcard, s=stop(only map until here)
 
     std::vector<int> mismatches; // vector of all string patterns
+    std::vector<matchingMode> matchingModes; // for all patterns: how variable barcodes are matched (edit distance, Hamming distance or automaton)
     std::vector<std::vector<std::string> > varyingBarcodes; // a vector storing for all non-constant barcode patterns in the order of occurence
                                                             // in the barcode pattern string the possible barcode sequences
     //fill the three vectors and handle as many errors as possible
-    parse_barcode_data(input, patterns, mismatches, varyingBarcodes);
+    parse_barcode_data(input, patterns, mismatches, matchingModes, varyingBarcodes);
 
     //iterate over patterns and fill BarcodePatternVector instance
     BarcodePatternVector barcodeVector;
@@ -236,15 +331,17 @@ std::vector<std::pair<std::string, char> > Mapping<MappingPolicy, FilePolicy>::g
     {
         if(patterns.at(i).second=='v')
         {
-            VariableBarcode barcode(varyingBarcodes.at(variableBarcodeIdx), mismatches.at(i));
+            VariableBarcode barcode(varyingBarcodes.at(variableBarcodeIdx), mismatches.at(i), matchingModes.at(i));
             std::shared_ptr<VariableBarcode> barcodePtr(std::make_shared<VariableBarcode>(barcode));
+            barcodePtr->enable_result_cache(input.matchCacheSize);
             barcodeVector.push_back(barcodePtr);
             
             //if we are at the AB/GUIDE barcode position, we need to here insert the guide sequences
             if(variableBarcodeIdx == input.guidePos)
             {
-                VariableBarcode barcode(*guideList, mismatches.at(i));
+                VariableBarcode barcode(*guideList, mismatches.at(i), matchingModes.at(i));
                 std::shared_ptr<VariableBarcode> barcodePtr(std::make_shared<VariableBarcode>(barcode));
+                barcodePtr->enable_result_cache(input.matchCacheSize);
                 guideBarcodeVector.push_back(barcodePtr);
             }
             else
@@ -300,6 +397,58 @@ std::vector<std::pair<std::string, char> > Mapping<MappingPolicy, FilePolicy>::g
     //set the vector of barcode patterns
     barcodePatterns = barcodePatternVector;
     guideBarcodePatterns = std::make_shared<BarcodePatternVector>(guideBarcodeVector);
+
+    //analyse the whitelists and report how they are matched
+    matchingPlan = "";
+    for(int i = 0; i < (int)barcodePatterns->size(); ++i)
+    {
+        std::string plan = barcodePatterns->at(i)->describe_matching_plan();
+        if(!plan.empty()){matchingPlan += "BARCODE " + std::to_string(i + 1) + ": " + plan;}
+    }
+    for(int i = 0; i < (int)guideBarcodePatterns->size(); ++i)
+    {
+        //all barcodes except the guides are shared with the normal barcode patterns
+        if(std::find(barcodePatterns->begin(), barcodePatterns->end(), guideBarcodePatterns->at(i)) != barcodePatterns->end()){continue;}
+        std::string plan = guideBarcodePatterns->at(i)->describe_matching_plan();
+        if(!plan.empty()){matchingPlan += "GUIDES: " + plan;}
+    }
+    if(!matchingPlan.empty())
+    {
+        std::cout << "MATCHING PLAN:\n" << matchingPlan;
+    }
+
+    //all linkers are searched in one scan of the read when mapping around them
+    std::vector<std::string> linkers;
+    for(const BarcodePatternPtr& pattern : *barcodePatterns)
+    {
+        if(pattern->is_constant()){linkers.push_back(pattern->get_patterns().at(0));}
+    }
+    if(!linkers.empty())
+    {
+        LinkerAnchorSearchPtr anchorSearch = std::make_shared<const LinkerAnchorSearch>(linkers);
+        for(const BarcodePatternPtr& pattern : *barcodePatterns){pattern->set_anchor_search(anchorSearch);}
+    }
+
+    //flat plans the policies walk through for every read
+    patternPlan = compile_barcode_plan(barcodePatterns);
+    guidePatternPlan = compile_barcode_plan(guideBarcodePatterns);
+    //offsets of the barcodes learned from the first reads (rounds for forward and reverse reads)
+    if(input.offsetModelReads > 0)
+    {
+        patternPlan.offsetModel = std::make_shared<BarcodeOffsetModel>(2 * patternPlan.steps.size(), input.offsetModelReads);
+        //guide reads are only mapped with a guide file, otherwise the model of the guide barcodes would never be learned
+        if(!guidePatternPlan.steps.empty() && (input.guideFile != ""))
+        {
+            guidePatternPlan.offsetModel = std::make_shared<BarcodeOffsetModel>(2 * guidePatternPlan.steps.size(), input.offsetModelReads);
+        }
+    }
+
+    //cache for the mapping of duplicated reads
+    readCache = nullptr;
+    if(input.readCacheSize > 0)
+    {
+        readCache = std::make_shared<ReadMappingCache>(input.readCacheSize);
+    }
     return patterns;
 }
 
@@ -307,7 +456,7 @@ std::vector<std::pair<std::string, char> > Mapping<MappingPolicy, FilePolicy>::g
 //realBarcodeMap contains the actual string in the seauence that gets a barcode assigned
 bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq, const input& input, 
                                         DemultiplexedReads& barcodeMap, 
-                                        BarcodePatternVectorPtr barcodePatterns,
+                                        const barcodePlan& plan,
                                         fastqStats& stats)
 {
     std::vector<std::string> barcodeList;
@@ -319,31 +468,38 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
     int old_offset = offset;
     unsigned int wildCardToFill = 0;
     int wildCardLength = 0, differenceInBarcodeLength = 0;
-    for(BarcodePatternVector::iterator patternItr = barcodePatterns->begin(); 
-        patternItr < barcodePatterns->end(); 
-        ++patternItr)
+    matchResult match; //result of the last matched barcode, reused for all barcodes
+    bool exactLayout = true; //all barcodes so far were exactly at their position
+
+    //reads without the linkers (e.g. PhiX, primer dimers) fail before any barcode is mapped,
+    //not with statistics: they also count the barcodes mapped in front of the failing one
+    if(!input.writeStats && !constant_barcodes_present(plan, seq.first))
+    {
+        ++stats.noMatches;
+        return false;
+    }
+    for(int stepIdx = 0; stepIdx < (int)plan.steps.size(); ++stepIdx)
     {
+        const barcodePlanStep& step = plan.steps[stepIdx];
 
         //if we have a wildcard skip this matching, we match again the next sequence
-        if((*patternItr)->is_wildcard())
+        if(step.type == barcodeStepType::WILDCARD)
         {
             if(!wildCardToFill)
             {
                 old_offset = offset;
             }
-            wildCardLength = (*patternItr)->get_patterns().at(0).length();
+            wildCardLength = step.length;
             offset += wildCardLength;
             wildCardToFill += 1;
             continue;
         }
-        else if((*patternItr)->is_stop())
+        else if(step.type == barcodeStepType::STOP)
         {
             //stop here: we do not continue mapping after stop barcode [*]
             break;
         }
         //for every barcodeMapping element find a match
-        std::string barcode = ""; //the actual real barcode that we find (mismatch corrected)
-        int start=0, end=0, score = 0;
         bool startCorrection = false;
         if(wildCardToFill){startCorrection = true;} // sart correction checks if we have to move our mapping window to the 5' direction
         // could happen in the case of deletions in the UMI sequence...
@@ -354,23 +510,29 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
             return false;
         }
 
-        if(!(*patternItr)->match_pattern(seq.first, offset, start, end, score, barcode, differenceInBarcodeLength, startCorrection, false))
+        //barcodes exactly at their position need no alignment, all others are aligned in shifted windows
+        match.differenceInBarcodeLength = differenceInBarcodeLength;
+        const bool exactMatch = step.barcode->match_exact(seq.first, offset, match);
+        exactLayout = exactLayout && exactMatch;
+        if(!exactMatch && !match_learned_offsets(plan, stepIdx, step, seq.first, offset, startCorrection, false, match) &&
+           !step.barcode->match_pattern_cached(seq.first, offset, match, startCorrection, false))
         {
             ++stats.noMatches;
             return false;
         }
+        const int start = match.seq_start, end = match.seq_end, score = match.score;
+        if(plan.offsetModel != nullptr){plan.offsetModel->record(stepIdx, start);}
+        std::string_view barcode = match.realBarcode; //the actual real barcode that we find (mismatch corrected)
+        differenceInBarcodeLength = match.differenceInBarcodeLength;
         
-        std::string sequence = seq.first.substr(offset + start, end-start);
         offset += end;
         score_sum += score;
 
-        assert(barcode != "");
+        assert(!barcode.empty());
         if(input.writeStats)
         {
             //add barcode data to statistics dictionary
-            std::lock_guard<std::mutex> guard(*stats.statsLock);
-            int dictvectorIndex = ( (score <= (*patternItr)->mismatches) ? (score) : ( ((*patternItr)->mismatches) + 1) );
-            ++stats.mapping_dict[barcode].at(dictvectorIndex);
+            count_barcode_mismatches(stats, barcode, score, step.mismatches);
         }
         
         //squeeze in the last wildcard match if there was one 
@@ -378,16 +540,13 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
         if(wildCardToFill)
         {
             startCorrection = false;
-            std::string oldWildcardMappedBarcode = seq.first.substr(old_offset, (offset+start-end) - old_offset);
+            std::string_view oldWildcardMappedBarcode = std::string_view(seq.first).substr(old_offset, (offset+start-end) - old_offset);
             //barcodeMap.emplace_back(uniqueChars.  (oldWildcardMappedBarcode));
             unsigned int lastWildcardEnd = 0; //in case we have several wildcards and need to know old offset
             // to subset new string
             while(wildCardToFill != 0)
             {
-                BarcodePatternVector::iterator wildCardIt = patternItr;
-                int pos = -1 * wildCardToFill;
-                std::advance(wildCardIt, pos);
-                int currentWildcardLength = (*wildCardIt)->get_patterns().at(0).length();
+                int currentWildcardLength = plan.steps[stepIdx - wildCardToFill].length;
                 //in case of deletions in UMI, we remove nucleotides from the last wildcard sequence
                 //for the last UMI sequence, we take the whole sequence (in case of insertions)
 
@@ -396,9 +555,9 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
                     currentWildcardLength = oldWildcardMappedBarcode.length() - lastWildcardEnd;
                 }
 
-                std::string wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
+                std::string_view wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
 
-                barcodeList.push_back(wildCardString);
+                barcodeList.emplace_back(wildCardString);
                 wildCardToFill -= 1;
 
                 lastWildcardEnd += currentWildcardLength; // add the lengths of barcodes to the next offset position
@@ -406,7 +565,7 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
         }
         //add this match to the BarcodeMapping
         //barcodeMap.emplace_back(std::make_shared<std::string>(mappedBarcode));
-        barcodeList.push_back(barcode);
+        barcodeList.emplace_back(barcode);
     }
     //if the last barcode was a WIldcard that still has to be added:
     //BE CAREFUL: for now this means there can be ONLY ONE UMI at the end of a sequence
@@ -420,7 +579,12 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
     }
 
     barcodeMap.addVector(barcodeList);
+    if(plan.offsetModel != nullptr){plan.offsetModel->read_mapped();}
 
+    if(exactLayout)
+    {
+        ++stats.exactLayoutMatches;
+    }
     if(score_sum == 0)
     {
         ++stats.perfectMatches;
@@ -434,11 +598,12 @@ bool MapEachBarcodeSequentiallyPolicy::split_line_into_barcode_patterns(std::pai
 }
 
 bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& seq, const input& input, 
-                                                           BarcodePatternVectorPtr barcodePatterns,
+                                                           const barcodePlan& plan,
                                                            fastqStats& stats,
                                                            std::vector<std::string>& barcodeList,
                                                            uint& barcodePosition,
-                                                           int& score_sum)
+                                                           int& score_sum,
+                                                           bool& exactLayout)
 {
 
     //iterate over BarcodeMappingVector
@@ -447,23 +612,23 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
     int old_offset = offset;
     unsigned int wildCardToFill = 0;
     int wildCardLength = 0, differenceInBarcodeLength = 0;
-    for(BarcodePatternVector::iterator patternItr = barcodePatterns->begin(); 
-        patternItr < barcodePatterns->end(); 
-        ++patternItr)
+    matchResult match; //result of the last matched barcode, reused for all barcodes
+    for(int stepIdx = 0; stepIdx < (int)plan.steps.size(); ++stepIdx)
     {
+        const barcodePlanStep& step = plan.steps[stepIdx];
         //if we have a wildcard skip this matching, we match again the next sequence
-        if((*patternItr)->is_wildcard())
+        if(step.type == barcodeStepType::WILDCARD)
         {
             if(!wildCardToFill)
             {
                 old_offset = offset;
             }
-            wildCardLength = (*patternItr)->get_patterns().at(0).length();
+            wildCardLength = step.length;
             offset += wildCardLength;
             wildCardToFill += 1;
             continue;
         }
-        else if((*patternItr)->is_stop())
+        else if(step.type == barcodeStepType::STOP)
         {
             //the stop positions is also a found position (count only for fw)
             ++barcodePosition; //increase the count of found positions
@@ -472,8 +637,6 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
         }
 
         //for every barcodeMapping element find a match
-        std::string barcode = ""; //the actual real barcode that we find (mismatch corrected)
-        int start=0, end=0, score = 0;
         bool startCorrection = false;
         if(wildCardToFill){startCorrection = true;} // sart correction checks if we have to move our mapping window to the 5' direction
         
@@ -485,27 +648,32 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
         }
 
         //if we did not match a pattern
-        if(!(*patternItr)->match_pattern(seq, offset, start, end, score, barcode, differenceInBarcodeLength, startCorrection, false))
+        match.differenceInBarcodeLength = differenceInBarcodeLength;
+        const bool exactMatch = step.barcode->match_exact(seq, offset, match);
+        exactLayout = exactLayout && exactMatch;
+        if(!exactMatch && !match_learned_offsets(plan, stepIdx, step, seq, offset, startCorrection, false, match) &&
+           !step.barcode->match_pattern_cached(seq, offset, match, startCorrection, false))
         {
             return false;
         }
+        const int start = match.seq_start, end = match.seq_end, score = match.score;
+        if(plan.offsetModel != nullptr){plan.offsetModel->record(stepIdx, start);}
+        std::string_view barcode = match.realBarcode; //the actual real barcode that we find (mismatch corrected)
+        differenceInBarcodeLength = match.differenceInBarcodeLength;
 
         //set the length difference after barcode mapping
         //for the case of insertions inside the barcode sequence set the difference explicitely to zero 
         //(we only focus on deletions that we can not distinguish from substitutions)
         //differenceInBarcodeLength = barcode.length() - (end);
         if(differenceInBarcodeLength<0){differenceInBarcodeLength=0;}
-        std::string sequence = seq.substr(offset + start, end-start);
         offset += end;
         score_sum += score;
 
-        assert(barcode != "");
+        assert(!barcode.empty());
         if(input.writeStats)
         {
             //add barcode data to statistics dictionary
-            std::lock_guard<std::mutex> guard(*stats.statsLock);
-            int dictvectorIndex = ( (score <= (*patternItr)->mismatches) ? (score) : ( ((*patternItr)->mismatches) + 1) );
-            ++stats.mapping_dict[barcode].at(dictvectorIndex);
+            count_barcode_mismatches(stats, barcode, score, step.mismatches);
         }
         
         //squeeze in the last wildcard match if there was one 
@@ -513,16 +681,13 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
         if(wildCardToFill)
         {
             startCorrection = false;
-            std::string oldWildcardMappedBarcode = seq.substr(old_offset, (offset+start-end) - old_offset);
+            std::string_view oldWildcardMappedBarcode = std::string_view(seq).substr(old_offset, (offset+start-end) - old_offset);
             //barcodeMap.emplace_back(uniqueChars.  (oldWildcardMappedBarcode));
             unsigned int lastWildcardEnd = 0; //in case we have several wildcards and need to know old offset
             // to subset new string
             while(wildCardToFill != 0)
             {
-                BarcodePatternVector::iterator wildCardIt = patternItr;
-                int pos = -1 * wildCardToFill;
-                std::advance(wildCardIt, pos);
-                int currentWildcardLength = (*wildCardIt)->get_patterns().at(0).length();
+                int currentWildcardLength = plan.steps[stepIdx - wildCardToFill].length;
                 //in case of deletions in UMI, we remove nucleotides from the last wildcard sequence
                 //for the last UMI sequence, we take the whole sequence (in case of insertions)
                 if( (lastWildcardEnd + currentWildcardLength) > oldWildcardMappedBarcode.length() || wildCardToFill == 1) 
@@ -530,8 +695,8 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
                     currentWildcardLength = oldWildcardMappedBarcode.length() - lastWildcardEnd;
                 }
 
-                std::string wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
-                barcodeList.push_back(wildCardString);
+                std::string_view wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
+                barcodeList.emplace_back(wildCardString);
                 wildCardToFill -= 1;
 
                 lastWildcardEnd += currentWildcardLength; // add the lengths of barcodes to the next offset position
@@ -541,7 +706,7 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
 
         //add this match to the BarcodeMapping
         //barcodeMap.emplace_back(std::make_shared<std::string>(mappedBarcode));
-        barcodeList.push_back(barcode);
+        barcodeList.emplace_back(barcode);
         ++barcodePosition; //increase the count of found positions
     }
     //if the last barcode was a WIldcard that still has to be added
@@ -558,11 +723,12 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_forward(const std::string& se
 }
 
 bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& seq, const input& input, 
-                                                           BarcodePatternVectorPtr barcodePatterns,
+                                                           const barcodePlan& plan,
                                                            fastqStats& stats,
                                                            std::vector<std::string>& barcodeList,
                                                            uint& barcodePosition,
-                                                           int& score_sum)
+                                                           int& score_sum,
+                                                           bool& exactLayout)
 {
     //iterate over BarcodeMappingVector
     int offset = 0;
@@ -570,32 +736,30 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
     int old_offset = offset;
     unsigned int wildCardToFill = 0;
     int wildCardLength = 0, differenceInBarcodeLength = 0;
+    matchResult match; //result of the last matched barcode, reused for all barcodes
     //iterate reverse through patterns
-    for(BarcodePatternVector::reverse_iterator patternItr = barcodePatterns->rbegin(); 
-        patternItr < barcodePatterns->rend(); 
-        ++patternItr)
+    for(int stepIdx = plan.steps.size() - 1; stepIdx >= 0; --stepIdx)
     {
+        const barcodePlanStep& step = plan.steps[stepIdx];
         //if we have a wildcard skip this matching, we match again the next sequence
-        if((*patternItr)->is_wildcard())
+        if(step.type == barcodeStepType::WILDCARD)
         {
             if(!wildCardToFill)
             {
                 old_offset = offset;
             }
-            wildCardLength = (*patternItr)->get_patterns().at(0).length();
+            wildCardLength = step.length;
             offset += wildCardLength;
             wildCardToFill += 1;
             continue;
         }
-        else if((*patternItr)->is_stop())
+        else if(step.type == barcodeStepType::STOP)
         {
             //stop here: we do not continue mapping after stop barcode [*]
             return true;
         }
 
         //for every barcodeMapping element find a match
-        std::string barcode = ""; //the actual real barcode that we find (mismatch corrected)
-        int start=0, end=0, score = 0;
         bool startCorrection = false;
         if(wildCardToFill){startCorrection = true;} // sart correction checks if we have to move our mapping window to the 5' direction
         
@@ -607,10 +771,20 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
         }
 
         //map each pattern with reverse complement
-        if(!(*patternItr)->match_pattern(seq, offset, start, end, score, barcode, differenceInBarcodeLength, startCorrection, true))
+        match.differenceInBarcodeLength = differenceInBarcodeLength;
+        const bool exactMatch = step.barcode->match_exact(seq, offset, match, true);
+        exactLayout = exactLayout && exactMatch;
+        //rounds of the reverse read follow the rounds of the forward read in the offset model
+        const int round = plan.steps.size() + stepIdx;
+        if(!exactMatch && !match_learned_offsets(plan, round, step, seq, offset, startCorrection, true, match) &&
+           !step.barcode->match_pattern_cached(seq, offset, match, startCorrection, true))
         {
             return false;
         }
+        const int start = match.seq_start, end = match.seq_end, score = match.score;
+        if(plan.offsetModel != nullptr){plan.offsetModel->record(round, start);}
+        std::string_view barcode = match.realBarcode; //the actual real barcode that we find (mismatch corrected)
+        differenceInBarcodeLength = match.differenceInBarcodeLength;
 
         //set the length difference after barcode mapping
         //for the case of insertions inside the barcode sequence set the difference explicitely to zero 
@@ -618,17 +792,14 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
         //we only substract the end, bcs we only consider barcode length differences at the end of the barcode
         //differenceInBarcodeLength = barcode.length() - (end);
         if(differenceInBarcodeLength<0){differenceInBarcodeLength=0;}
-        std::string sequence = seq.substr(offset + start, end-start);
         offset += end;
         score_sum += score;
 
-        assert(barcode != "");
+        assert(!barcode.empty());
         if(input.writeStats)
         {
             //add barcode data to statistics dictionary
-            std::lock_guard<std::mutex> guard(*stats.statsLock);
-            int dictvectorIndex = ( (score <= (*patternItr)->mismatches) ? (score) : ( ((*patternItr)->mismatches) + 1) );
-            ++stats.mapping_dict[barcode].at(dictvectorIndex);
+            count_barcode_mismatches(stats, barcode, score, step.mismatches);
         }
         
         //squeeze in the last wildcard match if there was one 
@@ -636,17 +807,14 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
         if(wildCardToFill)
         {
             startCorrection = false;
-            std::string oldWildcardMappedBarcode = seq.substr(old_offset, (offset+start-end) - old_offset);
+            std::string_view oldWildcardMappedBarcode = std::string_view(seq).substr(old_offset, (offset+start-end) - old_offset);
 
             //barcodeMap.emplace_back(uniqueChars.  (oldWildcardMappedBarcode));
             unsigned int lastWildcardEnd = 0; //in case we have several wildcards and need to know old offset
             // to subset new string
             while(wildCardToFill != 0)
             {
-                BarcodePatternVector::reverse_iterator wildCardIt = patternItr;
-                int pos = -1 * wildCardToFill;
-                std::advance(wildCardIt, pos);
-                int currentWildcardLength = (*wildCardIt)->get_patterns().at(0).length();
+                int currentWildcardLength = plan.steps[stepIdx + wildCardToFill].length;
                 //in case of deletions in UMI, we remove nucleotides from the last wildcard sequence
                 //for the last UMI sequence, we take the whole sequence (in case of insertions)
                 if( (lastWildcardEnd + currentWildcardLength) > oldWildcardMappedBarcode.length() || wildCardToFill == 1) 
@@ -654,10 +822,10 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
                     currentWildcardLength = oldWildcardMappedBarcode.length() - lastWildcardEnd;
                 }
 
-                std::string wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
+                std::string_view wildCardString = oldWildcardMappedBarcode.substr(lastWildcardEnd, currentWildcardLength);
 
                 //in reverse mapping we have to make reverse complement of wildcard sequence
-                std::string reverseComplimentbarcode = Barcode::generate_reverse_complement(wildCardString);
+                std::string reverseComplimentbarcode = Barcode::generate_reverse_complement(std::string(wildCardString));
 
                 barcodeList.push_back(reverseComplimentbarcode);
                 wildCardToFill -= 1;
@@ -671,7 +839,7 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
 
         //add this match to the BarcodeMapping
         //barcodeMap.emplace_back(std::make_shared<std::string>(mappedBarcode));
-        barcodeList.push_back(barcode);
+        barcodeList.emplace_back(barcode);
         ++barcodePosition; //increase the count of found positions
     }
     //if the last barcode was a WIldcard that still has to be added
@@ -688,7 +856,7 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::map_reverse(const std::string& se
 }
 
 bool MapEachBarcodeSequentiallyPolicyPairwise::combine_mapping(DemultiplexedReads& barcodeMap,
-                                                               const BarcodePatternVectorPtr& barcodePatterns,
+                                                               const barcodePlan& plan,
                                                                std::vector<std::string>& barcodeListFw,
                                                                const uint& barcodePositionFw,
                                                                const std::vector<std::string>& barcodeListRv,
@@ -698,7 +866,7 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::combine_mapping(DemultiplexedRead
                                                                std::pair<const std::string&, const std::string&> seq)
 {
     //check that we span the whole sequence (except constant regions)
-    int patternNum = barcodePatterns->size();
+    int patternNum = plan.steps.size();
 
     //if positions are next to each other just return
     //in case of a stop pattern [*], we added +1 to the barcodePositionFw, so that barcodePositionFw+barcodePositionRv should be euqual to patternNum
@@ -744,12 +912,12 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::combine_mapping(DemultiplexedRead
 
         for(int i = start; i <= end; ++i)
         {
-            if(!(barcodePatterns->at(i)->is_constant()))
+            if(plan.steps.at(i).type != barcodeStepType::CONSTANT)
             {
                 ++stats.noMatches;
                 return false;
             }
-            barcodeListFw.push_back(barcodePatterns->at(i)->get_patterns().at(0));
+            barcodeListFw.emplace_back(plan.steps.at(i).pattern);
         }
 
         //add reverse patterns
@@ -775,7 +943,7 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::combine_mapping(DemultiplexedRead
 
 bool MapEachBarcodeSequentiallyPolicyPairwise::split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq, const input& input, 
                                         DemultiplexedReads& barcodeMap, 
-                                        BarcodePatternVectorPtr barcodePatterns,
+                                        const barcodePlan& plan,
                                         fastqStats& stats)
 {
 
@@ -784,17 +952,94 @@ bool MapEachBarcodeSequentiallyPolicyPairwise::split_line_into_barcode_patterns(
     //barcodePosition is the psoiton of the last mapped barcode
     std::vector<std::string> barcodeListFw;
     uint barcodePositionFw = 0;
-    bool fwBool = map_forward(seq.first, input, barcodePatterns, stats, barcodeListFw, barcodePositionFw, score_sum);
+    bool exactLayout = true; //all barcodes of both reads exactly at their position
+    bool fwBool = map_forward(seq.first, input, plan, stats, barcodeListFw, barcodePositionFw, score_sum, exactLayout);
 
     std::vector<std::string> barcodeListRv;
     uint barcodePositionRv = 0;
-    bool rvBool = map_reverse(seq.second, input, barcodePatterns, stats, barcodeListRv, barcodePositionRv, score_sum);
+    bool rvBool = map_reverse(seq.second, input, plan, stats, barcodeListRv, barcodePositionRv, score_sum, exactLayout);
 
-    bool pairwiseMappingSuccess = combine_mapping(barcodeMap, barcodePatterns, barcodeListFw, barcodePositionFw, barcodeListRv, barcodePositionRv, stats, score_sum, seq);
+    bool pairwiseMappingSuccess = combine_mapping(barcodeMap, plan, barcodeListFw, barcodePositionFw, barcodeListRv, barcodePositionRv, stats, score_sum, seq);
+    if(pairwiseMappingSuccess && (plan.offsetModel != nullptr)){plan.offsetModel->read_mapped();}
+    if(pairwiseMappingSuccess && exactLayout)
+    {
+        ++stats.exactLayoutMatches;
+    }
 
     return (pairwiseMappingSuccess);
 }
 
+template <typename MappingPolicy, typename FilePolicy>
+bool Mapping<MappingPolicy, FilePolicy>::map_read_with_cache(std::pair<const std::string&, const std::string&> seq, const input& input, 
+                                                             DemultiplexedReads& readMap, const barcodePlan& patterns, 
+                                                             bool guideMapping)
+{
+    //reads of the warm-up of the learned offsets are mapped differently than the same reads afterwards, therefore they are not cached
+    if( (readCache == nullptr) || ((patterns.offsetModel != nullptr) && !patterns.offsetModel->is_learned()) )
+    {
+        return this->split_line_into_barcode_patterns(seq, input, readMap, patterns, stats);
+    }
+
+    //the mapping only depends on the sequences and on which barcode patterns we use
+    const char patternTag = guideMapping ? 'g' : 'b';
+    const uint64_t hash = ReadMappingCache::read_hash(seq.first, seq.second, patternTag);
+    bool admit = false;
+    ReadMappingRecordPtr record = readCache->find(seq.first, seq.second, patternTag, hash, admit);
+    if( (record == nullptr) && !admit )
+    {
+        //first occurence of the read: map it directly into the results
+        return this->split_line_into_barcode_patterns(seq, input, readMap, patterns, stats);
+    }
+    if(record == nullptr)
+    {
+        //the read is seen again: map it into empty structures, to store everything it adds to the results
+        DemultiplexedReads recordedMap;
+        fastqStats recordedStats;
+        recordedStats.statsLock = std::make_unique<std::mutex>();
+        std::shared_ptr<readMappingRecord> newRecord = std::make_shared<readMappingRecord>();
+        newRecord->mapped = this->split_line_into_barcode_patterns(seq, input, recordedMap, patterns, recordedStats);
+        for(const BarcodeMapping& barcodes : recordedMap.get_all_reads())
+        {
+            newRecord->barcodeVectors.emplace_back(barcodes.begin(), barcodes.end());
+        }
+        newRecord->perfectMatches = recordedStats.perfectMatches;
+        newRecord->moderateMatches = recordedStats.moderateMatches;
+        newRecord->noMatches = recordedStats.noMatches;
+        newRecord->exactLayoutMatches = recordedStats.exactLayoutMatches;
+        newRecord->mapping_dict = std::move(recordedStats.mapping_dict);
+        readCache->insert(seq.first, seq.second, patternTag, hash, newRecord);
+        record = newRecord;
+    }
+
+    //replay the mapping (also for the occurence that stored it)
+    for(const std::vector<std::string>& barcodes : record->barcodeVectors)
+    {
+        readMap.addVector(barcodes);
+    }
+    stats.perfectMatches += record->perfectMatches;
+    stats.moderateMatches += record->moderateMatches;
+    stats.noMatches += record->noMatches;
+    stats.exactLayoutMatches += record->exactLayoutMatches;
+    if(!record->mapping_dict.empty())
+    {
+        std::lock_guard<std::mutex> guard(*stats.statsLock);
+        for(const std::pair<const std::string, std::vector<int> >& mismatchDictEntry : record->mapping_dict)
+        {
+            std::vector<int>& mismatchVector = stats.mapping_dict[mismatchDictEntry.first];
+            if(mismatchVector.empty())
+            {
+                mismatchVector.assign(mismatchDictEntry.second.size(), 0);
+            }
+            for(int mismatchCountIdx = 0; mismatchCountIdx < (int)mismatchDictEntry.second.size(); ++mismatchCountIdx)
+            {
+                mismatchVector.at(mismatchCountIdx) += mismatchDictEntry.second.at(mismatchCountIdx);
+            }
+        }
+    }
+
+    return record->mapped;
+}
+
 template <typename MappingPolicy, typename FilePolicy>
 bool Mapping<MappingPolicy, FilePolicy>::demultiplex_read(std::pair<const std::string&, const std::string&> seq, const input& input, 
                                                           std::atomic<unsigned long long>& count, const unsigned long long& totalReadCount,
@@ -805,11 +1050,11 @@ bool Mapping<MappingPolicy, FilePolicy>::demultiplex_read(std::pair<const std::s
     bool result;
     if(!guideMapping)
     {
-        result = this->split_line_into_barcode_patterns(seq, input, barcodeMap, barcodePatterns, stats);
+        result = map_read_with_cache(seq, input, barcodeMap, patternPlan, false);
     }
     else
     {
-        result = this->split_line_into_barcode_patterns(seq, input, guideBarcodeMap, guideBarcodePatterns, stats);
+        result = map_read_with_cache(seq, input, guideBarcodeMap, guidePatternPlan, true);
         --stats.noMatches;
     }
 
@@ -827,37 +1072,33 @@ bool Mapping<MappingPolicy, FilePolicy>::demultiplex_read(std::pair<const std::s
 
 void MapAroundConstantBarcodesAsAnchorPolicy::map_pattern_between_linker(const std::string& seq, const int& oldEnd, 
                                                                          const int& start,
-                                                                         BarcodePatternVectorPtr barcodePatterns,
+                                                                         const barcodePlan& plan,
                                                                          std::vector<std::string>& barcodeList,
                                                                          int& barcodePosition, int& skippedBarcodes)
 {
     //we have to map all barcodes that we missed
-    int skipend=oldEnd;
-    std::string skippedBarcodeString = seq.substr(skipend, start-skipend);
-    int skipStringNewOffset = 0;
+    std::string_view skippedBarcodeString = std::string_view(seq).substr(oldEnd, start-oldEnd);
+    matchResult skipMatch;
     for(int i = barcodePosition-skippedBarcodes; i < barcodePosition ; ++i)
     {
-        BarcodePatternVector::iterator skippedPatternItr = barcodePatterns->begin() + i;
-        std::string skippedBarcode = ""; //the actual real barcode that we find (mismatch corrected)
-        int skipstart=0, skipscore = 0, skipdifferenceInBarcodeLength = 0;
+        skipMatch.differenceInBarcodeLength = 0;
 
-        if(!(*skippedPatternItr)->match_pattern(skippedBarcodeString, 0, skipstart, skipend, skipscore, skippedBarcode, skipdifferenceInBarcodeLength, false, false, true))
+        if(!plan.steps[i].barcode->match_pattern_cached(skippedBarcodeString, 0, skipMatch, false, false, true))
         {
             barcodeList.push_back("");
         }
         else
         {
-            skipStringNewOffset = skipend;
-            skippedBarcodeString.erase(0,skipStringNewOffset);
-
-            barcodeList.push_back(skippedBarcode);
+            //the actual real barcode that we find (mismatch corrected)
+            barcodeList.emplace_back(skipMatch.realBarcode);
+            skippedBarcodeString.remove_prefix(skipMatch.seq_end);
         }
     }
 }
 
 bool MapAroundConstantBarcodesAsAnchorPolicy::split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq, const input& input, 
                                         DemultiplexedReads& barcodeMap, 
-                                        BarcodePatternVectorPtr barcodePatterns,
+                                        const barcodePlan& plan,
                                         fastqStats& stats)
 {
     int offset = 0;
@@ -865,16 +1106,20 @@ bool MapAroundConstantBarcodesAsAnchorPolicy::split_line_into_barcode_patterns(s
 
     std::vector<std::string> barcodeList;
 
+    //scores of all linkers in the read, the read is scanned once for all of them
+    thread_local linkerScores anchorScan;
+    const LinkerAnchorSearch* anchorSearch = plan.anchorSearch;
+    if(anchorSearch != nullptr){anchorSearch->scan(seq.first, anchorScan);}
+
     //firstly map each constant barcode
     int barcodePosition = 0;
     int skippedBarcodes = 0;
-    for(BarcodePatternVector::iterator patternItr = barcodePatterns->begin(); 
-        patternItr < barcodePatterns->end(); 
-        ++patternItr)
+    for(int stepIdx = 0; stepIdx < (int)plan.steps.size(); ++stepIdx)
     {
+        const barcodePlanStep& step = plan.steps[stepIdx];
 
         //exclude non constant
-        if(!(*patternItr)->is_constant())
+        if(step.type != barcodeStepType::CONSTANT)
         {
             ++barcodePosition;
             ++skippedBarcodes;
@@ -882,17 +1127,19 @@ bool MapAroundConstantBarcodesAsAnchorPolicy::split_line_into_barcode_patterns(s
         }
         
         //map next constant region
-        int start=0, end=0, score = 0, differenceInBarcodeLength = 0;
-        std::string barcode = ""; //the actual real barcode that we find (mismatch corrected)
-            
-        std::string subStringToSearchBarcodes = seq.first.substr(oldEnd, seq.first.length() - oldEnd);
+        matchResult match;
+        std::string_view subStringToSearchBarcodes = std::string_view(seq.first).substr(oldEnd, seq.first.length() - oldEnd);
 
-        if(!(*patternItr)->match_pattern(subStringToSearchBarcodes, offset, start, end, score, barcode, differenceInBarcodeLength, false, false, true))
+        bool matched = (anchorSearch != nullptr) ? step.barcode->match_anchor(subStringToSearchBarcodes, anchorScan, oldEnd, match)
+                                                 : step.barcode->match_pattern_cached(subStringToSearchBarcodes, offset, match, false, false, true);
+        if(!matched)
         {
             ++barcodePosition;
             ++skippedBarcodes;
             continue;
         }
+        const int start = match.seq_start, end = match.seq_end;
+        std::string_view barcode = match.realBarcode; //the actual real barcode that we find (mismatch corrected)
 
         //if(start < oldEnd)
         //{
@@ -905,13 +1152,13 @@ bool MapAroundConstantBarcodesAsAnchorPolicy::split_line_into_barcode_patterns(s
         //1.) write the skipped barcodes so far
         if(skippedBarcodes > 0)
         {
-            map_pattern_between_linker(seq.first,oldEnd, start, barcodePatterns, barcodeList, barcodePosition, skippedBarcodes);
+            map_pattern_between_linker(seq.first,oldEnd, start, plan, barcodeList, barcodePosition, skippedBarcodes);
             //std::string skippedBarcodeString = seq.first.substr(oldEnd, start-oldEnd);
             //barcodeList.push_back(skippedBarcodeString);
         }
 
         //2.) write the newly mapped constant barcode
-        barcodeList.push_back(barcode);
+        barcodeList.emplace_back(barcode);
 
         //set paramters after constant mapping
         oldEnd += end;
@@ -922,7 +1169,7 @@ bool MapAroundConstantBarcodesAsAnchorPolicy::split_line_into_barcode_patterns(s
     if(skippedBarcodes > 0)
     {
         int start = seq.first.length();
-        map_pattern_between_linker(seq.first,oldEnd, start, barcodePatterns, barcodeList, barcodePosition, skippedBarcodes);
+        map_pattern_between_linker(seq.first,oldEnd, start, plan, barcodeList, barcodePosition, skippedBarcodes);
         //std::string skippedBarcodeString = seq.first.substr(oldEnd, start-oldEnd);
         //barcodeList.push_back(skippedBarcodeString);
     }
@@ -938,32 +1185,168 @@ void Mapping<MappingPolicy, FilePolicy>::run_mapping(const input& input)
 {
     std::cout << "START DEMULTIPLEXING\n";
 
-    //generate a pool of threads
-    boost::asio::thread_pool pool(input.threads); //create thread pool
-
-    //read line by line and add to thread pool
+    //read the file in batches and map them in the thread pool
     FilePolicy::init_file(input.inFile, input.reverseFile);
-    std::pair<std::string, std::string> line;
     std::atomic<unsigned long long> lineCount = 0; //using atomic<int> as thread safe read count
     unsigned long long totalReadCount = FilePolicy::get_read_number();
 
-    while(FilePolicy::get_next_line(line))
-    {
-        //handing over only lineCount as reference, everything else will be copied (Mapping object as handed overr as this-pointer)
-        //be aware: in default function do not handle guide reads, this is part of the overwritten function in Demultiplexing tool
-        boost::asio::post(pool, std::bind(&Mapping::demultiplex_read, this, line, input, std::ref(lineCount), totalReadCount, false));
-    }
-    pool.join();
+    //be aware: in default function do not handle guide reads, this is part of the overwritten function in Demultiplexing tool
+    map_reads_in_batches(input, [this, &input, &lineCount, &totalReadCount](std::pair<const std::string&, const std::string&> line)
+                         {
+                             demultiplex_read(line, input, lineCount, totalReadCount, false);
+                         });
     printProgress(1); std::cout << "\n"; // end the progress bar
     if(totalReadCount != ULLONG_MAX)
     {
         std::cout << "=>\t READS WITH A MATCHED BARCODE: " << std::to_string((unsigned long long)(100*(stats.perfectMatches)/(double)totalReadCount)) 
                 << "% | MODERATE MATCHES: " << std::to_string((unsigned long long)(100*(stats.moderateMatches)/(double)totalReadCount))
-                << "% | Linker sequences mapped non sequentially (e.g. same linker sequences): " << std::to_string((unsigned long long)(100*(stats.noMatches)/(double)totalReadCount)) << "%\n";
+                << "% | Linker sequences mapped non sequentially (e.g. same linker sequences): " << std::to_string((unsigned long long)(100*(stats.noMatches)/(double)totalReadCount))
+                << "% | EXACT LAYOUT (NO ALIGNMENT): " << std::to_string((unsigned long long)(100*(stats.exactLayoutMatches)/(double)totalReadCount)) << "%\n";
     }
+    print_result_cache_stats();
+    print_traceback_warnings();
     FilePolicy::close_file();
 }
 
+template <typename MappingPolicy, typename FilePolicy>
+void Mapping<MappingPolicy, FilePolicy>::map_reads_in_batches(const input& input, 
+                                                              const std::function<void(std::pair<const std::string&, const std::string&>)>& mapRead)
+{
+    //with a bucket size every thread gets several batches, so that all threads stay busy while the queue is limited
+    int batchSize = READ_BATCH_SIZE;
+    if(input.fastqReadBucketSize > 0)
+    {
+        batchSize = MAX(1LL, MIN((long long int)READ_BATCH_SIZE, input.fastqReadBucketSize / (4LL * input.threads)));
+    }
+    long long int elementsInQueue = 0; //reads posted to the pool and not mapped yet
+
+    //all batches (filled, in the queue or mapped) and the mapped ones that can be filled again, a mapped batch wakes up the reader
+    //(waiting for space in the bucket) with batchMapped. Only the reader adds batches to the list or erases them
+    std::list<readBatch> batches;
+    std::vector<std::list<readBatch>::iterator> mappedBatches;
+    std::mutex mappedBatchesLock;
+    std::condition_variable batchMapped;
+
+    //generate a pool of threads
+    boost::asio::thread_pool pool(input.threads); //create thread pool
+
+    bool moreReads = true;
+    while(moreReads)
+    {
+        std::list<readBatch>::iterator batch = batches.end();
+        {
+            std::lock_guard<std::mutex> guard(mappedBatchesLock);
+            if(!mappedBatches.empty())
+            {
+                batch = mappedBatches.back();
+                mappedBatches.pop_back();
+            }
+            //batches that are not needed anymore (e.g. the reader was slower than the threads for a while) are freed
+            while(mappedBatches.size() > MAX_SPARE_READ_BATCHES)
+            {
+                batches.erase(mappedBatches.back());
+                mappedBatches.pop_back();
+            }
+        }
+        if(batch == batches.end())
+        {
+            batches.emplace_back();
+            batch = std::prev(batches.end());
+            batch->reads.resize(batchSize);
+        }
+
+        //read the next batch
+        batch->size = 0;
+        while( (batch->size < batchSize) && (moreReads = FilePolicy::get_next_line(batch->reads.at(batch->size))) )
+        {
+            ++batch->size;
+        }
+        if(batch->size == 0){break;}
+
+        //wait to enqueue new reads in case we have a maximum bucket size (a batch is always posted if nothing else is queued).
+        //While offsets are learned the batches are mapped one after the other, so that the same reads are learned from with any number of threads
+        std::unique_lock<std::mutex> queueLock(mappedBatchesLock);
+        batchMapped.wait(queueLock, [this, &input, &elementsInQueue, &batch]()
+                         {
+                             return (elementsInQueue == 0) || 
+                                    ( !learning_offsets() && 
+                                      ((input.fastqReadBucketSize <= 0) || (elementsInQueue + batch->size <= input.fastqReadBucketSize)) );
+                         });
+        //one task maps the whole batch and hands it back to the reader
+        elementsInQueue += batch->size;
+        queueLock.unlock();
+        boost::asio::post(pool, [batch, &mapRead, &elementsInQueue, &mappedBatches, &mappedBatchesLock, &batchMapped]()
+                          {
+                              for(int readIdx = 0; readIdx < batch->size; ++readIdx)
+                              {
+                                  const std::pair<std::string, std::string>& read = batch->reads[readIdx];
+                                  mapRead(std::pair<const std::string&, const std::string&>(read.first, read.second));
+                              }
+                              {
+                                  std::lock_guard<std::mutex> guard(mappedBatchesLock);
+                                  elementsInQueue -= batch->size;
+                                  mappedBatches.push_back(batch);
+                              }
+                              batchMapped.notify_one();
+                          });
+    }
+    pool.join();
+}
+
+template <typename MappingPolicy, typename FilePolicy>
+void Mapping<MappingPolicy, FilePolicy>::print_result_cache_stats()
+{
+    std::vector<BarcodePatternVectorPtr> patternVectors = {barcodePatterns, guideBarcodePatterns};
+    for(int vectorIdx = 0; vectorIdx < (int)patternVectors.size(); ++vectorIdx)
+    {
+        if(patternVectors.at(vectorIdx) == nullptr){continue;}
+        for(int patternIdx = 0; patternIdx < (int)patternVectors.at(vectorIdx)->size(); ++patternIdx)
+        {
+            const MatchResultCachePtr& cache = patternVectors.at(vectorIdx)->at(patternIdx)->get_result_cache();
+            //guide patterns share all barcodes except the guide itself with the normal patterns
+            if(cache == nullptr || (vectorIdx == 1 && 
+               std::find(barcodePatterns->begin(), barcodePatterns->end(), guideBarcodePatterns->at(patternIdx)) != barcodePatterns->end()))
+            {
+                continue;
+            }
+            //no line for barcodes that were never looked up in their cache (e.g. mapped to the whole read around a linker)
+            const unsigned long long lookups = cache->get_hits() + cache->get_misses();
+            if(lookups == 0){continue;}
+            std::cout << "=>\tRESULT CACHE OF " << (vectorIdx == 0 ? "BARCODE " : "GUIDE BARCODE ") << std::to_string(patternIdx + 1) 
+                      << ": " << std::to_string(cache->get_hits()) << " HITS | " << std::to_string(cache->get_misses()) << " MISSES";
+            std::cout << " (" << std::to_string((unsigned long long)(100*cache->get_hits()/(double)lookups)) << "% HIT RATE)\n";
+        }
+    }
+    if(readCache != nullptr)
+    {
+        std::cout << "=>\tDUPLICATED READS (MAPPING REPLAYED): " << std::to_string(readCache->get_hits()) 
+                  << " | MAPPED READS: " << std::to_string(readCache->get_misses()) << "\n";
+    }
+}
+
+template <typename MappingPolicy, typename FilePolicy>
+void Mapping<MappingPolicy, FilePolicy>::print_traceback_warnings()
+{
+    //windows are only discarded like this if the lanes or an index report another score than the alignment of the pattern (a bug)
+    std::vector<BarcodePatternVectorPtr> patternVectors = {barcodePatterns, guideBarcodePatterns};
+    for(int vectorIdx = 0; vectorIdx < (int)patternVectors.size(); ++vectorIdx)
+    {
+        if(patternVectors.at(vectorIdx) == nullptr){continue;}
+        for(int patternIdx = 0; patternIdx < (int)patternVectors.at(vectorIdx)->size(); ++patternIdx)
+        {
+            const unsigned long long disagreements = patternVectors.at(vectorIdx)->at(patternIdx)->get_traceback_disagreements();
+            if(disagreements == 0 || (vectorIdx == 1 && 
+               std::find(barcodePatterns->begin(), barcodePatterns->end(), guideBarcodePatterns->at(patternIdx)) != barcodePatterns->end()))
+            {
+                continue;
+            }
+            std::cerr << "WARNING: " << std::to_string(disagreements) << " WINDOWS OF " << (vectorIdx == 0 ? "BARCODE " : "GUIDE BARCODE ") 
+                      << std::to_string(patternIdx + 1) << " WERE NOT MAPPED, THE ALIGNMENT DID NOT CONFIRM THE SCORE OF THE SEARCH "
+                      << "(PLEASE REPORT THIS AS A BUG)\n";
+        }
+    }
+}
+
 
 template <typename MappingPolicy, typename FilePolicy>
 void Mapping<MappingPolicy, FilePolicy>::run(const input& input)
@@ -12,9 +12,14 @@
 #include <regex>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
 #include <cmath>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <functional>
 
 #include "Barcode.hpp"
 #include "seqtk/kseq.h"
@@ -76,6 +81,126 @@ class DemultiplexedReads
 
 };
 
+//number of independently locked parts of the read cache
+#define READ_CACHE_SHARDS 64
+
+/** @brief everything the mapping of one read adds to the results: the mapped barcodes and the changes of the statistics.
+ * Stored for reads we have seen before, to replay their mapping instead of mapping them again.
+ **/
+struct readMappingRecord
+{
+    bool mapped = false;
+    std::vector<std::vector<std::string> > barcodeVectors; //barcodes added to the DemultiplexedReads
+    unsigned long long perfectMatches = 0;
+    unsigned long long moderateMatches = 0;
+    unsigned long long noMatches = 0;
+    unsigned long long exactLayoutMatches = 0;
+    std::map<std::string, std::vector<int> > mapping_dict; //mismatches of the barcodes (only barcodes of this read)
+};
+typedef std::shared_ptr<const readMappingRecord> ReadMappingRecordPtr;
+
+/** @brief bounded least recently used cache of the mapping results of whole reads (the forward and reverse sequence and the patterns used),
+ * shared by all threads. Reads are found by a hash of their sequences, the sequences are only copied for reads that are stored.
+ * A read is only stored when it is seen the second time, so that reads without duplicates cost only the lookup.
+ **/
+class ReadMappingCache
+{
+    public:
+    ReadMappingCache(const int& capacity)
+    {
+        for(int shardIdx = 0; shardIdx < READ_CACHE_SHARDS; ++shardIdx)
+        {
+            shards.push_back(std::make_unique<cacheShard>());
+            shards.back()->capacity = MAX(1, capacity / READ_CACHE_SHARDS);
+            shards.back()->seenOnce.assign(shards.back()->capacity, 0);
+        }
+    }
+
+    //hash of a read and the tag of the patterns used to map it
+    static uint64_t read_hash(std::string_view forward, std::string_view reverse, const char& patternTag)
+    {
+        const uint64_t forwardHash = std::hash<std::string_view>()(forward);
+        const uint64_t reverseHash = std::hash<std::string_view>()(reverse);
+        return (forwardHash ^ (reverseHash + 0x9e3779b97f4a7c15ULL + (forwardHash << 6) + (forwardHash >> 2))) + (unsigned char)patternTag;
+    }
+
+    //the stored mapping of the read, or nullptr: then admit is set if the read was seen before and its mapping should be stored
+    ReadMappingRecordPtr find(std::string_view forward, std::string_view reverse, const char& patternTag, const uint64_t& hash, bool& admit)
+    {
+        cacheShard& shard = get_shard(hash);
+        admit = false;
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            std::unordered_map<uint64_t, std::list<cacheEntry>::iterator>::iterator entry = shard.entries.find(hash);
+            if( (entry != shard.entries.end()) && same_read(entry->second->key, forward, reverse, patternTag) )
+            {
+                //move to the front of the least recently used list
+                shard.usage.splice(shard.usage.begin(), shard.usage, entry->second);
+                ++hits;
+                return entry->second->record;
+            }
+            if(entry == shard.entries.end())
+            {
+                //reads seen once are only remembered by their hash, in a table where a new read replaces the one in its slot
+                uint64_t& seenSlot = shard.seenOnce[(hash / READ_CACHE_SHARDS) % shard.seenOnce.size()];
+                admit = (seenSlot == hash);
+                seenSlot = hash;
+            }
+        }
+        ++misses;
+        return nullptr;
+    }
+
+    void insert(std::string_view forward, std::string_view reverse, const char& patternTag, const uint64_t& hash, const ReadMappingRecordPtr& record)
+    {
+        cacheShard& shard = get_shard(hash);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        //the read might have been inserted by another thread in the meantime
+        if(shard.entries.find(hash) != shard.entries.end()){return;}
+        if(shard.usage.size() >= shard.capacity)
+        {
+            shard.entries.erase(shard.usage.back().hash);
+            shard.usage.pop_back();
+        }
+        std::string key;
+        key.reserve(forward.length() + reverse.length() + 2);
+        key.append(forward).append(1, '\n').append(reverse).append(1, patternTag);
+        shard.usage.push_front({hash, std::move(key), record});
+        shard.entries.emplace(hash, shard.usage.begin());
+    }
+
+    unsigned long long get_hits() const {return hits;}
+    unsigned long long get_misses() const {return misses;}
+
+    private:
+    struct cacheEntry
+    {
+        uint64_t hash;
+        std::string key; //forward and reverse sequence and the tag of the patterns, to tell reads with the same hash apart
+        ReadMappingRecordPtr record;
+    };
+    struct cacheShard
+    {
+        std::mutex lock;
+        size_t capacity = 1;
+        std::list<cacheEntry> usage; //most recently used first
+        std::unordered_map<uint64_t, std::list<cacheEntry>::iterator> entries;
+        std::vector<uint64_t> seenOnce; //hashes of reads seen once, but not stored yet
+    };
+    static bool same_read(const std::string& key, std::string_view forward, std::string_view reverse, const char& patternTag)
+    {
+        return (key.length() == forward.length() + reverse.length() + 2) && (key.compare(0, forward.length(), forward) == 0) &&
+               (key.compare(forward.length() + 1, reverse.length(), reverse) == 0) && (key.back() == patternTag);
+    }
+    cacheShard& get_shard(const uint64_t& hash)
+    {
+        return *shards[hash % READ_CACHE_SHARDS];
+    }
+    std::vector<std::unique_ptr<cacheShard> > shards;
+    std::atomic<unsigned long long> hits = 0;
+    std::atomic<unsigned long long> misses = 0;
+};
+
 /** @brief mapping sequentially each barcode leaving no pattern out,
  *if a pattern can not be found the read is discarded
  **/
@@ -83,7 +208,7 @@ class MapEachBarcodeSequentiallyPolicy
 {
     public:
         bool split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq, const input& input, DemultiplexedReads& barcodeMap,
-                                      BarcodePatternVectorPtr barcodePatterns, fastqStats& stats);
+                                      const barcodePlan& plan, fastqStats& stats);
 };
 
 /** @brief like the sequential barcode mapping policy, for paired-end reads
@@ -92,19 +217,21 @@ class MapEachBarcodeSequentiallyPolicyPairwise
 {
     private:
         bool map_forward(const std::string& seq, const input& input, 
-                        BarcodePatternVectorPtr barcodePatterns,
+                        const barcodePlan& plan,
                         fastqStats& stats,
                         std::vector<std::string>& barcodeList,
                         uint& barcodePosition,
-                        int& score_sum);
+                        int& score_sum,
+                        bool& exactLayout);
         bool map_reverse(const std::string& seq, const input& input, 
-                        BarcodePatternVectorPtr barcodePatterns,
+                        const barcodePlan& plan,
                         fastqStats& stats,
                         std::vector<std::string>& barcodeList,
                         uint& barcodePosition,
-                        int& score_sum);
+                        int& score_sum,
+                        bool& exactLayout);
         bool combine_mapping(DemultiplexedReads& barcodeMap,
-                             const BarcodePatternVectorPtr& barcodePatterns,
+                             const barcodePlan& plan,
                              std::vector<std::string>& barcodeListFw, //this list is extended to real list
                              const uint& barcodePositionFw,
                              const std::vector<std::string>& barcodeListRv,
@@ -114,7 +241,7 @@ class MapEachBarcodeSequentiallyPolicyPairwise
                              std::pair<const std::string&, const std::string&> seq);
     public:
         bool split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq,  const input& input, DemultiplexedReads& barcodeMap,
-                                      BarcodePatternVectorPtr barcodePatterns, fastqStats& stats);
+                                      const barcodePlan& plan, fastqStats& stats);
 };
 
 /**
@@ -125,9 +252,9 @@ class MapAroundConstantBarcodesAsAnchorPolicy
 {
     public:
     bool split_line_into_barcode_patterns(std::pair<const std::string&, const std::string&> seq, const input& input, DemultiplexedReads& barcodeMap,
-                                      BarcodePatternVectorPtr barcodePatterns, fastqStats& stats);
+                                      const barcodePlan& plan, fastqStats& stats);
     void map_pattern_between_linker(const std::string& seq, const int& oldEnd, const int& start, 
-                                    BarcodePatternVectorPtr barcodePatterns, std::vector<std::string>& barcodeList,
+                                    const barcodePlan& plan, std::vector<std::string>& barcodeList,
                                     int& barcodePosition, int& skippedBarcodes);
 };
 
@@ -228,13 +355,14 @@ class ExtractLinesFromFastqFilePolicy
             }
             return false;
         }
+        //assigned to the existing strings: reused lines keep their memory
         if(!reverse)
         {
-            line.first = std::string(ks->seq.s);
+            line.first.assign(ks->seq.s, ks->seq.l);
         }
         else
         {
-            line.second = std::string(ks->seq.s);
+            line.second.assign(ks->seq.s, ks->seq.l);
         }
         return true;
     }
@@ -289,6 +417,18 @@ class ExtractLinesFromFastqFilePolicyPairedEnd
         ExtractLinesFromFastqFilePolicy rvFileManager;
 };
 
+//maximum number of reads that are mapped in one task of the thread pool
+#define READ_BATCH_SIZE 1024
+//mapped batches that are kept to be filled again, further ones are freed
+#define MAX_SPARE_READ_BATCHES 4
+
+//reads that are mapped in one task of the thread pool, batches are filled again once they are mapped (the reads keep their memory)
+struct readBatch
+{
+    std::vector<std::pair<std::string, std::string> > reads;
+    int size = 0; //number of reads of this batch
+};
+
 /** @brief generic class for the barcode mapping
  * @param MappingPolicy: the policy used to map one barcode after the other, probably mostly used one should be
  * MapEachBarcodeSequentiallyPolicy
@@ -335,12 +475,23 @@ class Mapping : protected MappingPolicy, protected FilePolicy
         {
             return stats.noMatches;
         }
+        ///number of lines with all barcodes exactly at their nominal positions (mapped without alignment)
+        const unsigned long long get_exact_layout_matches()
+        {
+            return stats.exactLayoutMatches;
+        }
         ///the dictionary of mismatches per barcode
         const std::map<std::string, std::vector<int> > get_mismatch_dict()
         {
             return stats.mapping_dict;
         }
 
+        ///how every variable barcode is matched (printed at the start of the mapping)
+        const std::string get_matching_plan()
+        {
+            return matchingPlan;
+        }
+
         ///run mapping over all reads of the input file
         void run(const input& input);
 
@@ -348,7 +499,7 @@ class Mapping : protected MappingPolicy, protected FilePolicy
 
         //parses all input arguments from barcode order, to mismatches in which barcodes etc.
         void parse_barcode_data(const input& input, std::vector<std::pair<std::string, char> >& patterns, std::vector<int>& mismatches, 
-                                std::vector<std::vector<std::string> >& varyingBarcodes);
+                                std::vector<matchingMode>& matchingModes, std::vector<std::vector<std::string> >& varyingBarcodes);
 
         /** @brief the structure that is filled during mapping, kind of our 'end result', that keeps that of all mapped barcodes
         *basically a vector of a vector of mapped barcodes, we can get this data after 'run' by calling 'get_demultiplexed_reads'
@@ -360,6 +511,9 @@ class Mapping : protected MappingPolicy, protected FilePolicy
         //basically a vector of Barcode objects (stores all possible barcodes, mismatches that are allowed, etc.)
         BarcodePatternVectorPtr barcodePatterns;
         BarcodePatternVectorPtr guideBarcodePatterns;
+        //the same patterns compiled into flat plans for the mapping of every read
+        barcodePlan patternPlan;
+        barcodePlan guidePatternPlan;
 
         //this is only filled if we map sequences that contain AB reads as well as guide reads
         //those guides can exist instead of ABs, if AB-barcodes do not map we try the guides
@@ -369,6 +523,8 @@ class Mapping : protected MappingPolicy, protected FilePolicy
 
         //statistics of the mapping
         fastqStats stats;
+        //description of the whitelists and the search used for every variable barcode
+        std::string matchingPlan;
         //lock for update bar
         std::unique_ptr<std::mutex> printProgressLock;  
 
@@ -397,4 +553,22 @@ class Mapping : protected MappingPolicy, protected FilePolicy
                               bool guideMapping);
         //run the actual mapping
         void run_mapping(const input& input);
+        //true while the offsets of the barcodes are learned from the first mapped reads (-l)
+        bool learning_offsets() const
+        {
+            return ( (patternPlan.offsetModel != nullptr) && !patternPlan.offsetModel->is_learned() ) || 
+                   ( (guidePatternPlan.offsetModel != nullptr) && !guidePatternPlan.offsetModel->is_learned() );
+        }
+        //map all reads of the opened input file in batches (one task of the thread pool per batch), mapRead is called for every read,
+        //the number of reads in the queue is limited by the fastqReadBucketSize
+        void map_reads_in_batches(const input& input, const std::function<void(std::pair<const std::string&, const std::string&>)>& mapRead);
+        //print hits and misses of the result caches of all barcodes (only barcodes with a cache) and of the read cache
+        void print_result_cache_stats();
+        void print_traceback_warnings();
+        //map a read with the mapping policy, or replay the mapping if the same read was mapped before
+        bool map_read_with_cache(std::pair<const std::string&, const std::string&> seq, const input& input, 
+                                 DemultiplexedReads& readMap, const barcodePlan& patterns, bool guideMapping);
+
+        //mapping results of whole reads, only set if reads are deduplicated
+        std::shared_ptr<ReadMappingCache> readCache = nullptr;
 };
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <memory>
+
+#include "helper.hpp"
+
+//scores of all linkers at every position of one read: score of linker l for the read up to position i (the last column of the
+//edit-matrix without unpunished deletions at the end) is scores[l * (readLength + 1) + i]
+struct linkerScores
+{
+    int readLength = 0;
+    std::vector<uint8_t> scores;
+};
+
+/**
+ * @brief approximate search of several linkers (constant barcodes of up to 64 bases) in a read with one scan:
+ * the linkers are packed next to each other into 64-bit words and aligned bit-parallel (Myers/Hyyroe) at the same time.
+ * Between two linkers of a word one bit stays unused, it takes the carry of the addition and the horizontal difference that is
+ * shifted out of the lower linker, so that every linker starts with a free first column like in a search of this linker alone.
+ **/
+class LinkerAnchorSearch
+{
+    public:
+    //linkers longer than 64 bases are not searched (index -1), the same linker is searched only once
+    LinkerAnchorSearch(const std::vector<std::string>& inLinkers)
+    {
+        for(const std::string& linker : inLinkers)
+        {
+            if(linker.empty() || (linker.length() > 64) || (linker_index(linker) >= 0)){continue;}
+            linkers.push_back(linker);
+        }
+
+        for(int linkerIdx = 0; linkerIdx < (int)linkers.size(); ++linkerIdx)
+        {
+            const int length = linkers.at(linkerIdx).length();
+            //a new word if the linker (and the unused bit in front of it) does not fit anymore
+            if(words.empty() || (words.back().usedBits + 1 + length > 64))
+            {
+                words.emplace_back();
+            }
+            linkerWord& word = words.back();
+            const int firstBit = word.linkerIdx.empty() ? 0 : (word.usedBits + 1);
+            if(firstBit > 0){word.separatorMask |= 1ULL << (firstBit - 1);}
+            for(int j = 0; j < length; ++j)
+            {
+                word.peq[(unsigned char)linkers.at(linkerIdx)[j]] |= 1ULL << (firstBit + j);
+                word.linkerMask |= 1ULL << (firstBit + j);
+            }
+            word.linkerIdx.push_back(linkerIdx);
+            word.lastBit.push_back(firstBit + length - 1);
+            linkerWordIdx.push_back(words.size() - 1);
+            linkerLastBit.push_back(firstBit + length - 1);
+            word.usedBits = firstBit + length;
+        }
+    }
+
+    //index of the linker in the scores, -1 if it is not searched
+    int linker_index(const std::string& linker) const
+    {
+        std::vector<std::string>::const_iterator found = std::find(linkers.begin(), linkers.end(), linker);
+        return (found == linkers.end()) ? -1 : (found - linkers.begin());
+    }
+    int linker_number() const {return linkers.size();}
+
+    //scan the read once and store the scores of all linkers at every position
+    void scan(std::string_view read, linkerScores& result) const
+    {
+        const int ls = read.length();
+        result.readLength = ls;
+        result.scores.resize(linkers.size() * (ls + 1));
+        for(const linkerWord& word : words)
+        {
+            uint64_t plus = word.linkerMask; //first row: 0,1,2,...,length for every linker
+            uint64_t minus = 0;
+            std::array<int, 64> lastColScore;
+            for(int l = 0; l < (int)word.linkerIdx.size(); ++l)
+            {
+                lastColScore[l] = linkers.at(word.linkerIdx.at(l)).length();
+                result.scores[word.linkerIdx.at(l) * (ls + 1)] = lastColScore[l];
+            }
+            for(int i = 1; i <= ls; ++i)
+            {
+                const uint64_t eq = word.peq[(unsigned char)read[i-1]];
+                const uint64_t xv = eq | minus;
+                const uint64_t xh = (((eq & plus) + plus) ^ plus) | eq;
+                uint64_t horizontalPlus = minus | ~(xh | plus);
+                uint64_t horizontalMinus = plus & xh;
+                for(int l = 0; l < (int)word.linkerIdx.size(); ++l)
+                {
+                    lastColScore[l] += (int)((horizontalPlus >> word.lastBit[l]) & 1ULL) - (int)((horizontalMinus >> word.lastBit[l]) & 1ULL);
+                    result.scores[word.linkerIdx[l] * (ls + 1) + i] = lastColScore[l];
+                }
+                //first column of every linker is zero (unlimited deletions in the beginning): the unused bits shift a zero into it
+                horizontalPlus = (horizontalPlus & ~word.separatorMask) << 1;
+                horizontalMinus = (horizontalMinus & ~word.separatorMask) << 1;
+                plus = (horizontalMinus | ~(xv | horizontalPlus)) & ~word.separatorMask;
+                minus = horizontalPlus & xv & ~word.separatorMask;
+            }
+        }
+    }
+
+    //true if a part of the read is within mismatches of the linker: the scan for this linker alone, that stops at the first hit
+    bool contains(std::string_view read, const int& linkerIdx, const int& mismatches) const
+    {
+        const linkerWord& word = words.at(linkerWordIdx.at(linkerIdx));
+        const int lastBit = linkerLastBit.at(linkerIdx);
+        int lastColScore = linkers.at(linkerIdx).length();
+        if(lastColScore <= mismatches){return true;}
+        uint64_t plus = word.linkerMask;
+        uint64_t minus = 0;
+        for(const char& base : read)
+        {
+            const uint64_t eq = word.peq[(unsigned char)base];
+            const uint64_t xv = eq | minus;
+            const uint64_t xh = (((eq & plus) + plus) ^ plus) | eq;
+            uint64_t horizontalPlus = minus | ~(xh | plus);
+            uint64_t horizontalMinus = plus & xh;
+            lastColScore += (int)((horizontalPlus >> lastBit) & 1ULL) - (int)((horizontalMinus >> lastBit) & 1ULL);
+            if(lastColScore <= mismatches){return true;}
+            horizontalPlus = (horizontalPlus & ~word.separatorMask) << 1;
+            horizontalMinus = (horizontalMinus & ~word.separatorMask) << 1;
+            plus = (horizontalMinus | ~(xv | horizontalPlus)) & ~word.separatorMask;
+            minus = horizontalPlus & xv & ~word.separatorMask;
+        }
+        return false;
+    }
+
+    //sequence is the scanned read from readOffset on, the result is exactly like levenshtein(sequence, linker, mismatches, ..., upperBoundCheck = true),
+    //but the linker is not searched again: for positions more than length + mismatches after readOffset an alignment starting before readOffset
+    //costs more than mismatches, so the scores of the scan of the whole read are the scores of the remaining read; only the positions before
+    //are aligned again. The best hit is aligned with backtracking like in levenshtein_search
+    bool find(const linkerScores& scan, const int& linkerIdx, std::string_view sequence, const int& readOffset, const int& mismatches,
+              int& match_start, int& match_end, int& score, int& endInPattern, int& startInPattern) const
+    {
+        const std::string& linker = linkers.at(linkerIdx);
+        const int ls = sequence.length();
+        const int la = linker.length();
+        const int margin = 2 * (la + mismatches) + 4;
+        if(ls <= margin)
+        {
+            return levenshtein(sequence, linker, mismatches, match_start, match_end, score, endInPattern, startInPattern, true);
+        }
+
+        //positions close to readOffset, the minimum of the last column includes the first row (score = length)
+        const int realigned = la + mismatches;
+        int bestRow = 0;
+        int bestScore = la;
+        int start, end;
+        levenshtein_bitparallel(sequence.substr(0, realigned), linker, la, start, end, bestScore, endInPattern, startInPattern, false, true, &bestRow);
+        //all other positions from the scan
+        const uint8_t* scores = scan.scores.data() + linkerIdx * (scan.readLength + 1) + readOffset;
+        for(int i = realigned + 1; i <= ls; ++i)
+        {
+            if(scores[i] < bestScore)
+            {
+                bestScore = scores[i];
+                bestRow = i;
+            }
+        }
+        if(bestScore > mismatches){return false;}
+
+        const int hitStart = MAX(0, bestRow - margin);
+        if(!levenshtein_bitparallel(sequence.substr(hitStart, bestRow - hitStart), linker, mismatches, match_start, match_end, score,
+                                    endInPattern, startInPattern))
+        {
+            return false;
+        }
+        match_start += hitStart;
+        match_end += hitStart;
+        return true;
+    }
+
+    private:
+    //linkers packed into one word: match-masks per character, bits of the linkers, unused bits between them, last bit of every linker
+    struct linkerWord
+    {
+        std::array<uint64_t, 256> peq{};
+        uint64_t linkerMask = 0;
+        uint64_t separatorMask = 0;
+        int usedBits = 0;
+        std::vector<int> linkerIdx;
+        std::vector<int> lastBit;
+    };
+    std::vector<std::string> linkers;
+    std::vector<linkerWord> words;
+    //word and last bit of every linker
+    std::vector<int> linkerWordIdx;
+    std::vector<int> linkerLastBit;
+};
+typedef std::shared_ptr<const LinkerAnchorSearch> LinkerAnchorSearchPtr;
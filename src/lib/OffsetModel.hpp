@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+
+//starts of barcodes are counted up to this many bases before or after their expected offset
+#define OFFSET_MODEL_MAX_SHIFT 8
+//number of learned shifts that are tried before a barcode is aligned
+#define OFFSET_MODEL_MAX_TRIES 4
+
+/**
+ * @brief offsets of the barcodes learned from the first reads: during a warm-up the reads are mapped with all windows and the start
+ * of every matched barcode relative to its expected offset (the shift) is counted for each round. Afterwards the shifts are tried
+ * in order of their frequency with an exact match before the barcode is aligned (e.g. for staggered primers or frequent indels)
+ **/
+class BarcodeOffsetModel
+{
+    public:
+    //rounds are all barcodes of a pattern (twice for forward and reverse reads), warmupReads is the number of mapped reads to learn from
+    BarcodeOffsetModel(const int& inRounds, const unsigned long long& inWarmupReads) :
+        rounds(inRounds), warmupReads(inWarmupReads), counts(inRounds), learnedShifts(inRounds)
+    {
+        for(std::array<std::atomic<unsigned long long>, 2 * OFFSET_MODEL_MAX_SHIFT + 1>& roundCounts : counts)
+        {
+            for(std::atomic<unsigned long long>& count : roundCounts){count = 0;}
+        }
+    }
+
+    //count the start of a barcode mapped in the warm-up (shifts outside of the counted range are ignored)
+    void record(const int& round, const int& shift)
+    {
+        if(is_learned() || (shift < -OFFSET_MODEL_MAX_SHIFT) || (shift > OFFSET_MODEL_MAX_SHIFT)){return;}
+        counts.at(round).at(shift + OFFSET_MODEL_MAX_SHIFT).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //a read was mapped completely, the thread that maps the last read of the warm-up orders the shifts
+    void read_mapped()
+    {
+        if(is_learned()){return;}
+        if(mappedReads.fetch_add(1, std::memory_order_relaxed) + 1 != warmupReads){return;}
+        for(int round = 0; round < rounds; ++round)
+        {
+            std::vector<std::pair<unsigned long long, int> > observed;
+            for(int shift = -OFFSET_MODEL_MAX_SHIFT; shift <= OFFSET_MODEL_MAX_SHIFT; ++shift)
+            {
+                const unsigned long long count = counts.at(round).at(shift + OFFSET_MODEL_MAX_SHIFT).load(std::memory_order_relaxed);
+                //the expected offset itself is always tried first (exact match before the alignment)
+                if( (shift != 0) && (count > 0) ){observed.emplace_back(count, shift);}
+            }
+            //most frequent shifts first, shifts closer to the expected offset for equal counts
+            std::sort(observed.begin(), observed.end(), [](const std::pair<unsigned long long, int>& a, const std::pair<unsigned long long, int>& b)
+                      {
+                          return (a.first != b.first) ? (a.first > b.first) : (std::abs(a.second) < std::abs(b.second));
+                      });
+            for(int i = 0; (i < (int)observed.size()) && (i < OFFSET_MODEL_MAX_TRIES); ++i)
+            {
+                learnedShifts.at(round).push_back(observed.at(i).second);
+            }
+        }
+        learned.store(true, std::memory_order_release);
+    }
+
+    bool is_learned() const {return learned.load(std::memory_order_acquire);}
+    //shifts of a round in the order they are tried (only valid once the model is learned)
+    const std::vector<int>& shifts(const int& round) const {return learnedShifts.at(round);}
+
+    private:
+    int rounds;
+    unsigned long long warmupReads;
+    std::atomic<unsigned long long> mappedReads = 0;
+    std::atomic<bool> learned = false;
+    std::vector<std::array<std::atomic<unsigned long long>, 2 * OFFSET_MODEL_MAX_SHIFT + 1> > counts;
+    std::vector<std::vector<int> > learnedShifts;
+};
+typedef std::shared_ptr<BarcodeOffsetModel> BarcodeOffsetModelPtr;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+
+//2-bit encoding of nucleotides: A=0, C=1, G=2, T=3 (the complement of a base is 3-code)
+//N has a code of its own, all other characters (also lowercase bases) are invalid
+constexpr uint8_t N_BASE = 4;
+constexpr uint8_t INVALID_BASE = 0xFF;
+
+//lookup tables for encoding and complementing single bases
+struct nucleotideTables
+{
+    uint8_t code[256];
+    char complement[256]; //0 for invalid characters
+    char base[4];
+
+    constexpr nucleotideTables() : code(), complement(), base{'A', 'C', 'G', 'T'}
+    {
+        for(int c = 0; c < 256; ++c)
+        {
+            code[c] = INVALID_BASE;
+            complement[c] = 0;
+        }
+        code['A'] = 0; code['C'] = 1; code['G'] = 2; code['T'] = 3; code['N'] = N_BASE;
+        complement['A'] = 'T'; complement['C'] = 'G'; complement['G'] = 'C'; complement['T'] = 'A'; complement['N'] = 'N';
+    }
+};
+inline constexpr nucleotideTables nucleotides{};
+
+inline char complement_base(const char& c)
+{
+    const char complement = nucleotides.complement[(unsigned char)c];
+    if(complement == 0)
+    {
+        throw std::domain_error("Invalid nucleotide.");
+    }
+    return complement;
+}
+
+inline std::string reverse_complement(std::string_view seq)
+{
+    std::string newSeq(seq.length(), 'N');
+    std::transform(seq.crbegin(), seq.crend(), newSeq.begin(), complement_base);
+    return newSeq;
+}
+
+//packs a sequence of up to 32 bases without N into one integer (first base in the lowest bits),
+//e.g. as key for barcodes of same length. Returns false if this is not possible
+inline bool pack_kmer(std::string_view seq, uint64_t& packed)
+{
+    if(seq.length() > 32){return false;}
+    packed = 0;
+    for(int i = 0; i < (int)seq.length(); ++i)
+    {
+        const uint64_t code = nucleotides.code[(unsigned char)seq[i]];
+        if(code > 3){return false;}
+        packed |= code << (2 * i);
+    }
+    return true;
+}
+
+//packs the first length bases of seq (up to 32) like pack_kmer, but N and invalid characters are stored as A with
+//both bits of their position set in nMask, so that they differ from every base in kmer_hamming_distance
+inline void pack_kmer_with_n_mask(std::string_view seq, const int& length, uint64_t& packed, uint64_t& nMask)
+{
+    assert(length <= 32 && length <= (int)seq.length());
+    packed = 0;
+    nMask = 0;
+    for(int i = 0; i < length; ++i)
+    {
+        const uint64_t code = nucleotides.code[(unsigned char)seq[i]];
+        if(code > 3)
+        {
+            nMask |= 3ULL << (2 * i);
+        }
+        else
+        {
+            packed |= code << (2 * i);
+        }
+    }
+}
+
+//number of differing bases of two packed kmers of same length, positions set in nMask (see pack_kmer_with_n_mask) always differ
+inline int kmer_hamming_distance(const uint64_t& a, const uint64_t& b, const uint64_t& nMask = 0)
+{
+    const uint64_t diff = (a ^ b) | nMask;
+    return __builtin_popcountll((diff | (diff >> 1)) & 0x5555555555555555ULL);
+}
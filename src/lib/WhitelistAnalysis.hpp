@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "helper.hpp"
+
+//number of pattern pairs that are compared to get the minimum edit distance of a whitelist,
+//larger whitelists are compared only for a sample of the patterns (the distance is then an upper bound)
+#define WHITELIST_ANALYSIS_MAX_PAIRS 500000
+
+//edit distance of two whole sequences, computed only up to cap (returns cap if the distance is at least cap),
+//rows is a buffer for two rows of the DP matrix that is reused between calls
+inline int bounded_edit_distance(std::string_view a, std::string_view b, const int& cap, std::vector<int>& rows)
+{
+    const int la = a.length();
+    const int lb = b.length();
+    if(std::abs(la - lb) >= cap){return cap;}
+
+    //band of the DP matrix: only cells with |i-j| < cap can have a value below cap
+    if((int)rows.size() < 2 * (lb + 1)){rows.resize(2 * (lb + 1));}
+    int* previous = rows.data();
+    int* current = rows.data() + lb + 1;
+    for(int j = 0; j <= lb; ++j){previous[j] = MIN(j, cap);}
+    for(int i = 1; i <= la; ++i)
+    {
+        const int first = MAX(1, i - cap + 1);
+        const int last = MIN(lb, i + cap - 1);
+        current[first - 1] = (first == 1) ? MIN(i, cap) : cap;
+        int rowMinimum = current[first - 1];
+        for(int j = first; j <= last; ++j)
+        {
+            const int diagonal = previous[j - 1] + (a[i - 1] != b[j - 1]);
+            const int up = ((j <= i + cap - 2) ? previous[j] : cap) + 1;
+            const int left = current[j - 1] + 1;
+            current[j] = MIN(cap, MIN(diagonal, MIN(up, left)));
+            rowMinimum = MIN(rowMinimum, current[j]);
+        }
+        if(last < lb){current[last + 1] = cap;}
+        if(rowMinimum >= cap){return cap;}
+        std::swap(previous, current);
+    }
+    return previous[lb];
+}
+
+/** @brief properties of the whitelist of a variable barcode that decide how it can be matched: number of patterns,
+ * their lengths and the minimum edit distance between two patterns
+ **/
+struct whitelistAnalysis
+{
+    int patternNumber = 0;
+    std::map<int, int> lengthDistribution; //number of patterns per length
+    int minDistance = 0; //minimum edit distance between two patterns (distanceCap if no pair is closer)
+    int distanceCap = 0; //distances are only computed up to this value
+    bool sampled = false; //if true, only a sample of the patterns was compared and minDistance is an upper bound
+};
+
+//computes the whitelist properties, the minimum distance is computed up to 4*mismatches+2 (enough to see if a read within mismatches
+//of a pattern can have the same distance to another pattern, see unique_score)
+inline whitelistAnalysis analyse_whitelist(const std::vector<std::string>& patterns, const int& mismatches)
+{
+    whitelistAnalysis analysis;
+    analysis.patternNumber = patterns.size();
+    for(const std::string& pattern : patterns)
+    {
+        ++analysis.lengthDistribution[pattern.length()];
+    }
+    analysis.distanceCap = 4 * mismatches + 2;
+    analysis.minDistance = analysis.distanceCap;
+    std::vector<int> rows;
+
+    //compare every pattern with all following ones, or a deterministic sample of patterns with all others
+    const unsigned long long allPairs = (unsigned long long)patterns.size() * (patterns.size() - (patterns.empty() ? 0 : 1)) / 2;
+    int step = 1;
+    if(allPairs > WHITELIST_ANALYSIS_MAX_PAIRS)
+    {
+        analysis.sampled = true;
+        step = (allPairs + WHITELIST_ANALYSIS_MAX_PAIRS - 1) / WHITELIST_ANALYSIS_MAX_PAIRS;
+    }
+    for(int i = 0; (i < (int)patterns.size()) && (analysis.minDistance > 0); i += step)
+    {
+        for(int j = (analysis.sampled ? 0 : i + 1); (j < (int)patterns.size()) && (analysis.minDistance > 0); ++j)
+        {
+            if(i == j){continue;}
+            analysis.minDistance = MIN(analysis.minDistance, bounded_edit_distance(patterns.at(i), patterns.at(j), analysis.minDistance, rows));
+        }
+    }
+    return analysis;
+}
+
+//highest score up to which a pattern is the only one with this or a lower score for any window, -1 if there is none: a window of the 
+//pattern length (or shorter) with scores s1, s2 to two patterns aligns them to two substrings of the window, that differ by at most 
+//s1 + s2 bases at their ends, so the patterns have a distance of at most 2*(s1+s2). A hit with 4*score < minDistance can then neither
+//be tied nor beaten. Only for whitelists of one length where all pairs were compared
+inline int unique_score(const whitelistAnalysis& analysis, const int& mismatches)
+{
+    if( analysis.sampled || (analysis.lengthDistribution.size() != 1) || (analysis.minDistance == 0) ){return -1;}
+    return MIN(mismatches, (analysis.minDistance - 1) / 4);
+}
@@ -9,6 +9,12 @@
 #include <cstring>
 #include <atomic>
 #include <mutex>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #define PBSTR "||||||||||||||||||||||||||||||||||||||||||||||||||||||||||||"
 #define PBWIDTH 60
@@ -108,6 +114,9 @@ struct input{
     bool writeFailedLines = false;
     long long int fastqReadBucketSize = 10000000;
     int threads = 5;
+    int matchCacheSize = 0; //results of barcode matching cached per variable barcode (0 disables the cache)
+    int readCacheSize = 0; //mapping results of whole reads cached to replay them for duplicated reads (0 disables the cache)
+    unsigned long long offsetModelReads = 0; //reads mapped with all windows to learn the offsets of the barcodes (0 disables the model)
 };
 
 struct fastqStats{
@@ -116,6 +125,8 @@ struct fastqStats{
     std::atomic<unsigned long long> perfectMatches = 0;
     std::atomic<unsigned long long> noMatches = 0;
     std::atomic<unsigned long long> moderateMatches = 0;
+    //lines whose barcodes were all found exactly at their nominal positions (without any alignment)
+    std::atomic<unsigned long long> exactLayoutMatches = 0;
     //parameter stating how often a barcode sequence could be matched to several sequences, can occure more than once per line
     //can only happen for vairable sequences
     //a dictionary of the number of mismatches in a barcode, in the case of a match
@@ -123,6 +134,20 @@ struct fastqStats{
     std::unique_ptr<std::mutex> statsLock;
 };
 
+//count a mapped barcode with score mismatches in the statistics dictionary (with one additional entry for scores above the allowed mismatches),
+//barcodes without an entry get one (e.g. if only the statistics of one read are collected)
+inline void count_barcode_mismatches(fastqStats& stats, std::string_view barcode, const int& score, const int& mismatches)
+{
+    std::lock_guard<std::mutex> guard(*stats.statsLock);
+    std::vector<int>& mismatchVector = stats.mapping_dict[std::string(barcode)];
+    if(mismatchVector.empty())
+    {
+        mismatchVector.assign(mismatches + 2, 0);
+    }
+    int dictvectorIndex = ( (score <= mismatches) ? (score) : (mismatches + 1) );
+    ++mismatchVector.at(dictvectorIndex);
+}
+
 struct levenshtein_value{
         unsigned int val = 0;
         int i = 0;
@@ -139,69 +164,131 @@ inline levenshtein_value min(levenshtein_value a, levenshtein_value b)
     return b;
 }
 
+//buffers of the alignment functions, they are kept per thread and only grow, so that aligning a sequence does not allocate memory
+//(the functions below do not call each other while using the same buffer)
+struct alignmentScratch
+{
+    //edit-matrix of levenshtein (flat) and pointers to its rows
+    std::vector<levenshtein_value> matrix;
+    std::vector<levenshtein_value*> matrixRows;
+    //rows of levenshtein_bitparallel
+    std::vector<uint64_t> rowPlus;
+    std::vector<uint64_t> rowMinus;
+    std::vector<int> lastCol;
+    //row of levenshtein_lanes_scalar and levenshtein_score
+    std::vector<int> laneRow;
+    //fronts of outputSense
+    std::vector<unsigned int> frontPrevious;
+    std::vector<unsigned int> frontCurrent;
+};
+inline alignmentScratch& alignment_scratch()
+{
+    thread_local alignmentScratch scratch;
+    return scratch;
+}
+
 struct frontMatrix
 {
-    std::vector<unsigned int> previous;
-    std::vector<unsigned int> current;
+    std::vector<unsigned int>& previous;
+    std::vector<unsigned int>& current;
     unsigned int offset;
     unsigned int d;
 
-    frontMatrix(unsigned int m, unsigned int n): previous(m+n+3, UINT_MAX), current(m+n+3, UINT_MAX){}
+    frontMatrix(unsigned int m, unsigned int n): previous(alignment_scratch().frontPrevious), current(alignment_scratch().frontCurrent)
+    {
+        previous.assign(m+n+3, UINT_MAX);
+        current.assign(m+n+3, UINT_MAX);
+    }
 };
-//calculate longest common prefix of two sequences
-inline int lcp(const std::string& a, const std::string& b)
+//calculate longest common prefix of two sequences (of at most len bases): compares 16 (SSE2) or 8 bytes at once
+//and counts the equal bytes in front of the first mismatch with ctz
+inline unsigned int lcp(const char* a, const char* b, const unsigned int& len)
 {
     unsigned int lcp = 0;
-    unsigned int a_len = a.length();
-    unsigned int b_len = b.length();
-    unsigned int len = (a_len > b_len) ? b_len : a_len;
-
-    while( (a[lcp] == b[lcp]) && (lcp < len) )
+#if defined(__x86_64__)
+    while(lcp + 16 <= len)
+    {
+        const __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + lcp)), _mm_loadu_si128((const __m128i*)(b + lcp)));
+        const unsigned int mismatchMask = ~_mm_movemask_epi8(equal) & 0xFFFF;
+        if(mismatchMask != 0)
+        {
+            return lcp + __builtin_ctz(mismatchMask);
+        }
+        lcp += 16;
+    }
+#endif
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while(lcp + 8 <= len)
+    {
+        uint64_t aWord, bWord;
+        memcpy(&aWord, a + lcp, 8);
+        memcpy(&bWord, b + lcp, 8);
+        if(aWord != bWord)
+        {
+            return lcp + (__builtin_ctzll(aWord ^ bWord) >> 3);
+        }
+        lcp += 8;
+    }
+#endif
+    while( (lcp < len) && (a[lcp] == b[lcp]) )
     {
         ++lcp;
     }
     return lcp;
 }
+inline unsigned int lcp(std::string_view a, std::string_view b)
+{
+    return lcp(a.data(), b.data(), MIN(a.length(), b.length()));
+}
 //calculates the next front
 //idea: how far along all the diagonals that r within x-mismatches can i go in my edit-matrix with x-mismatches
-inline void front(const std::string& a, const std::string& b, frontMatrix& f)
+inline void front(std::string_view a, std::string_view b, frontMatrix& f)
 {
-    unsigned int min = MIN(a.length(), f.d);
-    unsigned int max = MIN(b.length(), f.d);
+    const unsigned int m = a.length();
+    const unsigned int n = b.length();
+    const unsigned int min = MIN(m, f.d);
+    const unsigned int max = MIN(n, f.d);
 
-    f.previous = f.current;
+    //the last front becomes the previous one, its buffer is reused for the new front
+    std::swap(f.previous, f.current);
+    const unsigned int* previous = f.previous.data();
+    unsigned int* current = f.current.data();
 
-    unsigned int l = 0;
     for(unsigned int i = (f.offset-min); i <= (f.offset + max); ++i)
     {
         unsigned int aVal = 0, bVal = 0, cVal = 0;
-        if(f.previous.at(i-1) != UINT_MAX){ aVal = f.previous.at(i-1);}
-        if(f.previous.at(i+1) != UINT_MAX){ bVal = f.previous.at(i+1)+1;}
-        if(f.previous.at(i) != UINT_MAX){ cVal = f.previous.at(i)+1;}
+        if(previous[i-1] != UINT_MAX){ aVal = previous[i-1];}
+        if(previous[i+1] != UINT_MAX){ bVal = previous[i+1]+1;}
+        if(previous[i] != UINT_MAX){ cVal = previous[i]+1;}
 
-        l = MAX(MAX(aVal, bVal), cVal);
-            
-            if(l >= a.length())
-            {
-                f.current.at(i) = a.length();
-            }
-            else if( (i - f.offset + l) >= b.length())
-            {
-                //in this case the row must be i, however it already is at this point...
-                //to set explicitely uncomment
-                //f.current.at(i) = i;
-            }
-            else
-            {
-                f.current.at(i) = l + lcp( a.substr(l), b.substr(i - f.offset + l) );
-            }    
+        //diagonal k: position l in a is position l + k in b
+        const int k = (int)i - (int)f.offset;
+        unsigned int l = MAX(MAX(aVal, bVal), cVal);
+        if((int)l < -k)
+        {
+            //the diagonal is not reached yet (it would start before b) and keeps its value of the last front
+            current[i] = previous[i];
+            continue;
+        }
+        //a substitution or insertion can not go past the end of b: the diagonal ends there
+        l = MIN(l, n - k);
+
+        if(l >= m)
+        {
+            current[i] = m;
+        }
+        else
+        {
+            const unsigned int bPos = l + k;
+            current[i] = l + lcp(a.data() + l, b.data() + bPos, MIN(m - l, n - bPos));
+        }    
     }
 
 }
 
 //output sensitive -> O() depends on the mismatches that we allow, since we allow mostly just for a few it runs super fast...
 //no backtracking implemented for now, only used to align UMIs where we do not care about alingment start, end
-inline bool outputSense(const std::string& sequence, const std::string& pattern, const int& mismatches, int& score)
+inline bool outputSense(std::string_view sequence, std::string_view pattern, const int& mismatches, int& score)
 {
     const unsigned int m = sequence.length();
     const unsigned int n = pattern.length();
@@ -210,24 +297,18 @@ inline bool outputSense(const std::string& sequence, const std::string& pattern,
     f.offset = m + 1;
     f.d = 0;
 
-    f.current.at(f.offset) = lcp(sequence, pattern);
-    if(f.current.at(n-m+f.offset) == m)
+    f.current[f.offset] = lcp(sequence, pattern);
+    if(f.current[n-m+f.offset] == m)
     {
         score = f.d;
         return true;
-        if(score <= mismatches){return true;}
-        else
-        {
-            score = mismatches + 1;
-            return false;
-        }
     }
 
     ++f.d;
     while(f.d <= MIN(MAX(m,n), mismatches))
     {
         front(sequence, pattern, f);
-        if(f.current.at(n-m+f.offset) == m )
+        if(f.current[n-m+f.offset] == m )
         {
             score = f.d;
             if(score <= mismatches)
@@ -248,32 +329,270 @@ inline bool outputSense(const std::string& sequence, const std::string& pattern,
     return false;
 }
 
-inline void free_levenshtein(levenshtein_value** dist, int ls)
+//bit-parallel version (Myers/Hyyroe) of levenshtein_matrix (below) for patterns of up to 64 bases: one row of the edit-matrix
+//is stored as two bit-vectors of +1/-1 differences between neighbouring columns, so a row costs a few word operations.
+//the rows are kept to do the exact same backtracking as the matrix version (same scores, same del > subst > ins preference)
+//with scoreOnly no rows are stored and only the score is calculated (match positions are not set), bestRow is then set to the first row 
+//(end in the sequence) where the last column reaches the score
+inline bool levenshtein_bitparallel(std::string_view sequence, std::string_view pattern, const int& mismatches, int& match_start, int& match_end,
+                                    int& score, int& endInPattern, int& startInPattern, bool upperBoundCheck = false, bool scoreOnly = false,
+                                    int* bestRow = nullptr)
 {
-    for (int i = 0; i <= ls; ++i) 
+    const int ls = sequence.length();
+    const int la = pattern.length();
+    assert(la > 0 && la <= 64);
+
+    //match-masks of the pattern per character, only entries of pattern characters are set and reset again at the end
+    thread_local uint64_t peq[256] = {0};
+    for(int j = 0; j < la; ++j)
+    {
+        peq[(unsigned char)pattern[j]] |= (1ULL << j);
+    }
+
+    //rowPlus/rowMinus: bit j-1 is set if dist[i][j] is one more/ less than dist[i][j-1]
+    //lastCol stores the last column, which allows unpunished deletions and is therefore tracked separately
+    alignmentScratch& scratch = alignment_scratch();
+    if(!scoreOnly && ((int)scratch.lastCol.size() < ls + 1))
+    {
+        scratch.rowPlus.resize(ls + 1);
+        scratch.rowMinus.resize(ls + 1);
+        scratch.lastCol.resize(ls + 1);
+    }
+    uint64_t* rowPlus = scratch.rowPlus.data();
+    uint64_t* rowMinus = scratch.rowMinus.data();
+    int* lastCol = scratch.lastCol.data();
+
+    const uint64_t lastBit = 1ULL << (la - 1);
+    uint64_t plus = ~0ULL; //first row: 0,1,2,...,la
+    uint64_t minus = 0;
+    int lastColScore = la; //last column without unpunished deletions
+    int lastColMinimum = la; //last column with unpunished deletions
+    int lastColMinimumRow = 0;
+    if(!scoreOnly)
+    {
+        rowPlus[0] = plus;
+        rowMinus[0] = minus;
+        lastCol[0] = la;
+    }
+    //same early termination as in the banded matrix version: if the sequence is not longer than the pattern
+    //every alignment with at most mismatches errors stays within the diagonals +/- mismatches. The value at the left border
+    //of the band is followed along its diagonal (starting at dist[mismatches][0] = 0), from there we walk through the band
+    const bool banded = upperBoundCheck && (ls <= la);
+    int bandStartValue = 0;
+    for(int i = 1; i <= ls; ++i)
+    {
+        const uint64_t eq = peq[(unsigned char)sequence[i-1]];
+        const uint64_t xv = eq | minus;
+        const uint64_t xh = (((eq & plus) + plus) ^ plus) | eq;
+        uint64_t horizontalPlus = minus | ~(xh | plus);
+        uint64_t horizontalMinus = plus & xh;
+        if(horizontalPlus & lastBit){++lastColScore;}
+        else if(horizontalMinus & lastBit){--lastColScore;}
+        if(banded && (i > mismatches))
+        {
+            //one step to the right in the previous row, one step down to this row
+            const int bit = i - mismatches - 1;
+            bandStartValue += (int)((plus >> bit) & 1ULL) - (int)((minus >> bit) & 1ULL)
+                            + (int)((horizontalPlus >> bit) & 1ULL) - (int)((horizontalMinus >> bit) & 1ULL);
+        }
+        //first column is always zero (unlimited deletions in beginning), therefore shift in a zero
+        horizontalPlus <<= 1;
+        horizontalMinus <<= 1;
+        plus = horizontalMinus | ~(xv | horizontalPlus);
+        minus = horizontalPlus & xv;
+
+        if(lastColScore < lastColMinimum)
+        {
+            lastColMinimum = lastColScore;
+            lastColMinimumRow = i;
+        }
+        if(!scoreOnly)
+        {
+            rowPlus[i] = plus;
+            rowMinus[i] = minus;
+            lastCol[i] = lastColMinimum;
+        }
+
+        if(banded && (i > mismatches))
+        {
+            const int firstCol = i - mismatches;
+            const int lastColumn = MIN(la - 1, i + mismatches);
+            int rowMinimum = (i + mismatches >= la) ? lastColMinimum : INT_MAX;
+            if(firstCol < la)
+            {
+                int value = bandStartValue;
+                rowMinimum = MIN(rowMinimum, value);
+                for(int j = firstCol; j < lastColumn; ++j)
+                {
+                    value += (int)((plus >> j) & 1ULL) - (int)((minus >> j) & 1ULL);
+                    rowMinimum = MIN(rowMinimum, value);
+                }
+            }
+            if(rowMinimum > mismatches)
+            {
+                for(int j = 0; j < la; ++j)
+                {
+                    peq[(unsigned char)pattern[j]] = 0;
+                }
+                return false;
+            }
+        }
+    }
+    for(int j = 0; j < la; ++j)
+    {
+        peq[(unsigned char)pattern[j]] = 0;
+    }
+
+    if(upperBoundCheck && (lastColMinimum > mismatches))
+    {
+        return false;
+    }
+    score = lastColMinimum;
+    if(score > mismatches)
+    {
+        return false;
+    }
+    if(scoreOnly)
+    {
+        if(bestRow != nullptr){*bestRow = lastColMinimumRow;}
+        return true;
+    }
+
+    //value of the edit-matrix at row i, column j
+    auto dist = [&](const int& i, const int& j)
+    {
+        if(j == la){return lastCol[i];}
+        const uint64_t mask = (1ULL << j) - 1;
+        return __builtin_popcountll(rowPlus[i] & mask) - __builtin_popcountll(rowMinus[i] & mask);
+    };
+
+    //backtracking exactly like in levenshtein: start is the first, end the last matching base of the alignment
+    int start = 0;
+    int end = 0;
+    int i = ls;
+    int j = la;
+    bool noEnd = true;
+    while(j!=0 && i!=0)
+    {
+        const bool baseMatch = (sequence[i-1] == pattern[j-1]);
+        const int deletionValue = dist(i-1, j) + ((j == la) ? 0 : 1);
+        const int substitutionValue = dist(i-1, j-1) + (baseMatch ? 0 : 1);
+        const int insertionValue = dist(i, j-1) + 1;
+
+        //if equal score, prefer: del  > subst > ins
+        const int tmp = MIN(substitutionValue, insertionValue);
+        if(deletionValue <= tmp)
+        {
+            --i;
+        }
+        else if(substitutionValue <= insertionValue)
+        {
+            if(baseMatch)
+            {
+                start = i;
+                startInPattern = j;
+                if(noEnd)
+                {
+                    noEnd = false;
+                    end = i;
+                    endInPattern = j;
+                }
+            }
+            --i;
+            --j;
+        }
+        else
+        {
+            --j;
+        }
+    }
+
+    assert(start!=0);
+    assert(startInPattern!=0);
+    match_start = start-1;
+    startInPattern -= 1;
+    match_end = end;
+    return true;
+}
+
+//score of levenshtein (below) without backtracking: the bit-parallel version without stored rows for patterns of up to 64 bases, 
+//otherwise the edit-matrix row by row. Like levenshtein, with upperBoundCheck windows (sequence not longer than pattern) are only
+//calculated in the band of diagonals +/- mismatches and the score is not set if it is above mismatches
+inline bool levenshtein_score(std::string_view sequence, std::string_view pattern, const int& mismatches, int& score, bool upperBoundCheck = false)
+{
+    if(!pattern.empty() && pattern.length() <= 64)
     {
-        delete[] dist[i];
+        int start, end, endInPattern, startInPattern;
+        return levenshtein_bitparallel(sequence, pattern, mismatches, start, end, score, endInPattern, startInPattern, upperBoundCheck, true);
     }
-    delete[] dist;
+
+    const int ls = sequence.length();
+    const int la = pattern.length();
+    const bool banded = upperBoundCheck && (ls <= la);
+    //cells outside of the band are never filled and keep a value above every possible score
+    const int outOfBand = ls + la + 1;
+    std::vector<int>& row = alignment_scratch().laneRow;
+    row.resize(la + 1);
+    for(int j = 0; j <= la; ++j){row[j] = j;}
+    for(int i = 1; i <= ls; ++i)
+    {
+        int firstCol = 1;
+        int lastColumn = la;
+        if(banded)
+        {
+            firstCol = MAX(1, i - mismatches);
+            lastColumn = MIN(la, i + mismatches);
+        }
+        //row[firstCol-1] is still the value of the last row (diagonal), left of the band the current row is out of band
+        int diagonal = row[firstCol - 1];
+        int left = (firstCol == 1) ? 0 : outOfBand;
+        if(firstCol == 1){row[0] = 0;}
+        int rowMinimum = INT_MAX;
+        for(int j = firstCol; j <= lastColumn; ++j)
+        {
+            const int above = ( banded && (j == lastColumn) && (j == i + mismatches) ) ? outOfBand : row[j];
+            const int substitution = diagonal + ((sequence[i-1] == pattern[j-1]) ? 0 : 1);
+            const int deletion = above + ((j == la) ? 0 : 1);
+            const int insertion = left + 1;
+            diagonal = row[j];
+            row[j] = MIN(MIN(substitution, deletion), insertion);
+            left = row[j];
+            rowMinimum = MIN(rowMinimum, row[j]);
+        }
+        if(banded && (i > mismatches) && (rowMinimum > mismatches))
+        {
+            return false;
+        }
+    }
+    if(upperBoundCheck && (row[la] > mismatches))
+    {
+        return false;
+    }
+    score = row[la];
+    return(score <= mismatches);
 }
 
 //levenshtein distance, implemented with backtracking to get start and end of alingment, however slower than output sensitive algorithm:
 //used for parser so far: it has an additional flavor of unpunished deletions at the start and end of the alignment
 //start is 0 indexed, end are the first indices that arre not part of the match
-inline bool levenshtein(const std::string sequence, std::string pattern, const int& mismatches, int& match_start, int& match_end, int& score,
-                        int& endInPattern, int& startInPattern, bool upperBoundCheck = false)
+//this is the edit-matrix version for patterns of any length, levenshtein (below) calls it for patterns of more than 64 bases
+inline bool levenshtein_matrix(std::string_view sequence, std::string_view pattern, const int& mismatches, int& match_start, int& match_end, int& score,
+                               int& endInPattern, int& startInPattern, bool upperBoundCheck = false)
 {
     int i,j,ls,la,substitutionValue, deletionValue;
     //stores the lenght of strings s1 and s2
     ls = sequence.length();
     la = pattern.length();
     //levenshtein_value dist[ls+1][la+1];
-    //dynamic allcation of edit-matrix
-    levenshtein_value** dist = new levenshtein_value*[ls + 1];
+    //edit-matrix in the reused buffer of this thread, all cells start with the default value
+    alignmentScratch& scratch = alignment_scratch();
+    scratch.matrix.assign((ls + 1) * (la + 1), levenshtein_value());
+    scratch.matrixRows.resize(ls + 1);
     for (int i = 0; i <= ls; ++i) 
     {
-        dist[i] = new levenshtein_value[la + 1];
+        scratch.matrixRows[i] = scratch.matrix.data() + i * (la + 1);
     }
+    levenshtein_value** dist = scratch.matrixRows.data();
 
     //allow unlimited deletions in beginning; start is zero
     for(i=0;i<=ls;i++) {
@@ -289,10 +608,21 @@ inline bool levenshtein(const std::string sequence, std::string pattern, const i
     levenshtein_value val(0,-1,-1);
     dist[0][0] = val;
 
-    int upperBoundCol = mismatches;
+    //with upperBoundCheck and a sequence that is not longer than the pattern only the diagonals within +/- mismatches can be part
+    //of an alignment with at most mismatches errors (a longer alignment needs more insertions/ deletions to get back to the end),
+    //all other cells keep their default value and are never filled
+    const bool banded = upperBoundCheck && (ls <= la);
     for (i=1;i<=ls;i++) 
     {
-        for(j=1;j<=la;j++) 
+        int firstCol = 1;
+        int lastColumn = la;
+        if(banded)
+        {
+            firstCol = MAX(1, i - mismatches);
+            lastColumn = MIN(la, i + mismatches);
+        }
+        unsigned int rowMinimum = UINT_MAX;
+        for(j=firstCol;j<=lastColumn;j++) 
         {
 
             //Punishement for substitution
@@ -333,28 +663,29 @@ inline bool levenshtein(const std::string sequence, std::string pattern, const i
             levenshtein_value tmp1 = min(subst, seq_ins);
             levenshtein_value tmp2 = min(seq_del, tmp1);
 
-            if(upperBoundCheck && (tmp2.val > mismatches) && (j > upperBoundCol) )
-            {
-                    upperBoundCol = j-1;
-                    break;
-            }
-            
             dist[i][j] = tmp2;
+            rowMinimum = MIN(rowMinimum, tmp2.val);
             //uncomment to show the edit-matrix
             //std::cout << tmp2.val << "(" << sequence[i-1] <<  ","<< pattern[j-1] << ")" << " ";
         }
         //std::cout << "\n";
+
+        //give up as soon as the whole band is above the threshold: every alignment passes this row, 
+        //except the ones starting later, which can not be within the band after the first mismatches rows
+        if(banded && (i > mismatches) && (rowMinimum > (unsigned int)mismatches))
+        {
+            return false;
+        }
     }
     if(upperBoundCheck && (dist[ls][la].val > mismatches))
     {
-        free_levenshtein(dist, ls);
         return false;
     }
     //backtracking to find match start and end
     // start and end are defined as first and last match of bases 
     //(deletion, insertion and substitution are not considered, since they could also be part of the adjacent sequences)
-    int start;
-    int end;
+    int start = 0;
+    int end = 0;
     i = ls;
     j =la;
     bool noEnd = true;
@@ -391,7 +722,6 @@ inline bool levenshtein(const std::string sequence, std::string pattern, const i
         match_start = start-1;
         startInPattern -= 1;
         match_end = end;
-        free_levenshtein(dist, ls);
         return true;
     }
     else
@@ -399,11 +729,369 @@ inline bool levenshtein(const std::string sequence, std::string pattern, const i
         score = (dist[ls][la]).val;
     }
 
-    free_levenshtein(dist, ls);
     return false;
 }
 
-inline int backBarcodeMappingExtension(const std::string& sequence, const std::string& pattern, int seq_end, const int& patternEnd)
+//levenshtein with backtracking like levenshtein_matrix: patterns of up to 64 bases are aligned with the bit-parallel version, which gives the exact same results
+inline bool levenshtein(std::string_view sequence, std::string_view pattern, const int& mismatches, int& match_start, int& match_end, int& score,
+                        int& endInPattern, int& startInPattern, bool upperBoundCheck = false)
+{
+    if(!pattern.empty() && pattern.length() <= 64)
+    {
+        return levenshtein_bitparallel(sequence, pattern, mismatches, match_start, match_end, score, endInPattern, startInPattern, upperBoundCheck);
+    }
+
+    //score-only pass first: the edit-matrix for the backtracking is only filled if the pattern maps
+    if(!levenshtein_score(sequence, pattern, mismatches, score, upperBoundCheck))
+    {
+        return false;
+    }
+    return levenshtein_matrix(sequence, pattern, mismatches, match_start, match_end, score, endInPattern, startInPattern, upperBoundCheck);
+}
+
+//levenshtein for a pattern in a long sequence (e.g. a linker in the whole read): the sequence is scanned once bit-parallel without storing
+//any rows to find the best score and where it ends, then only the part of the sequence around this hit is aligned again with backtracking.
+//Gives the exact same results as levenshtein: the backtracking goes up the last column to the first row with the best score, from there the
+//alignment uses at most length + mismatches rows, and alignments starting before the realigned part cost more than mismatches + 2 in those rows
+inline bool levenshtein_search(std::string_view sequence, std::string_view pattern, const int& mismatches, int& match_start, int& match_end, int& score,
+                               int& endInPattern, int& startInPattern, bool upperBoundCheck = false)
+{
+    const int la = pattern.length();
+    const int margin = 2 * (la + mismatches) + 4;
+    if(pattern.empty() || (la > 64) || ((int)sequence.length() <= margin))
+    {
+        return levenshtein(sequence, pattern, mismatches, match_start, match_end, score, endInPattern, startInPattern, upperBoundCheck);
+    }
+
+    int bestRow = 0;
+    int start, end;
+    if(!levenshtein_bitparallel(sequence, pattern, mismatches, start, end, score, endInPattern, startInPattern, upperBoundCheck, true, &bestRow))
+    {
+        return false;
+    }
+    const int hitStart = MAX(0, bestRow - margin);
+    if(!levenshtein_bitparallel(sequence.substr(hitStart, bestRow - hitStart), pattern, mismatches, match_start, match_end, score, 
+                                endInPattern, startInPattern))
+    {
+        return false;
+    }
+    match_start += hitStart;
+    match_end += hitStart;
+    return true;
+}
+
+//patterns of the same length stored transposed in blocks of laneBlockSize: base j of all patterns of a block lies next to each other,
+//so that one sequence window is aligned against a whole block at once in SIMD lanes (unused lanes are 0 and never match a base)
+constexpr int laneBlockSize = 32;
+//kernel scoring one block of lanes, see levenshtein_lanes_scalar
+typedef void (*laneKernelFunction)(std::string_view sequence, const uint8_t* bases, const int& la, const int& cap, int* scores);
+struct patternLanes
+{
+    int length = 0;
+    std::vector<int> patternIdx; //index of each lane in the original pattern vector
+    std::vector<uint8_t> bases; //base j of lane l in block b: bases[(b * length + j) * laneBlockSize + l]
+    //kernel specialised for length and fixedMismatches (only for windows of full length), nullptr if there is none
+    laneKernelFunction fixedKernel = nullptr;
+    int fixedMismatches = -1;
+};
+
+//result of aligning one sequence against all patterns of patternLanes
+struct laneAlignmentResult
+{
+    int bestScore = INT_MAX;
+    int bestCount = 0; //number of patterns with the best score
+    int bestIdx = -1; //first pattern (index in the original pattern vector) with the best score
+};
+
+//group patterns by their length, the order of the patterns is kept within each group
+inline std::vector<patternLanes> generate_pattern_lanes(const std::vector<std::string>& patterns)
+{
+    std::map<int, std::vector<int> > patternIdxByLength;
+    for(int patternIdx = 0; patternIdx < (int)patterns.size(); ++patternIdx)
+    {
+        patternIdxByLength[patterns.at(patternIdx).length()].push_back(patternIdx);
+    }
+
+    std::vector<patternLanes> laneGroups;
+    for(const std::pair<const int, std::vector<int> >& lengthGroup : patternIdxByLength)
+    {
+        patternLanes lanes;
+        lanes.length = lengthGroup.first;
+        lanes.patternIdx = lengthGroup.second;
+        const int blocks = (lanes.patternIdx.size() + laneBlockSize - 1) / laneBlockSize;
+        lanes.bases.assign(blocks * lanes.length * laneBlockSize, 0);
+        for(int lane = 0; lane < (int)lanes.patternIdx.size(); ++lane)
+        {
+            const std::string& pattern = patterns.at(lanes.patternIdx.at(lane));
+            const int block = lane / laneBlockSize;
+            for(int j = 0; j < lanes.length; ++j)
+            {
+                lanes.bases[(block * lanes.length + j) * laneBlockSize + (lane % laneBlockSize)] = pattern[j];
+            }
+        }
+        laneGroups.push_back(lanes);
+    }
+    return laneGroups;
+}
+
+//the lane kernels calculate only the score of levenshtein (same edit-matrix: free deletions at beginning and end of the sequence) 
+//for all lanes of one block, values are capped at cap (mismatches + 1), which is enough to decide if and how good a pattern maps
+inline void levenshtein_lanes_scalar(std::string_view sequence, const uint8_t* bases, const int& la, const int& cap, int* scores)
+{
+    std::vector<int>& row = alignment_scratch().laneRow;
+    row.resize(la + 1);
+    for(int lane = 0; lane < laneBlockSize; ++lane)
+    {
+        for(int j = 0; j <= la; ++j){row[j] = MIN(j, cap);}
+        for(int i = 0; i < (int)sequence.length(); ++i)
+        {
+            int diagonal = row[0];
+            for(int j = 1; j <= la; ++j)
+            {
+                const int substitution = diagonal + ((bases[(j-1) * laneBlockSize + lane] == (uint8_t)sequence[i]) ? 0 : 1);
+                const int deletion = row[j] + ((j == la) ? 0 : 1);
+                const int insertion = row[j-1] + 1;
+                diagonal = row[j];
+                row[j] = MIN(MIN(substitution, deletion), MIN(insertion, cap));
+            }
+        }
+        scores[lane] = row[la];
+    }
+}
+
+#if defined(__x86_64__)
+//SSE2 is always available on x86-64: a block is aligned in two halves of 16 lanes
+inline void levenshtein_lanes_sse2(std::string_view sequence, const uint8_t* bases, const int& la, const int& cap, int* scores)
+{
+    __m128i row[65];
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i capVector = _mm_set1_epi8((char)cap);
+    for(int half = 0; half < laneBlockSize; half += 16)
+    {
+        for(int j = 0; j <= la; ++j){row[j] = _mm_set1_epi8((char)MIN(j, cap));}
+        for(int i = 0; i < (int)sequence.length(); ++i)
+        {
+            const __m128i base = _mm_set1_epi8(sequence[i]);
+            __m128i diagonal = row[0];
+            for(int j = 1; j <= la; ++j)
+            {
+                const __m128i patternBase = _mm_loadu_si128((const __m128i*)(bases + (j-1) * laneBlockSize + half));
+                const __m128i substitution = _mm_adds_epu8(diagonal, _mm_andnot_si128(_mm_cmpeq_epi8(patternBase, base), one));
+                const __m128i deletion = (j == la) ? row[j] : _mm_adds_epu8(row[j], one);
+                const __m128i insertion = _mm_adds_epu8(row[j-1], one);
+                diagonal = row[j];
+                row[j] = _mm_min_epu8(_mm_min_epu8(substitution, deletion), _mm_min_epu8(insertion, capVector));
+            }
+        }
+        uint8_t laneScores[16];
+        _mm_storeu_si128((__m128i*)laneScores, row[la]);
+        for(int lane = 0; lane < 16; ++lane){scores[half + lane] = laneScores[lane];}
+    }
+}
+
+//AVX2 is only used if the CPU supports it (checked at runtime), so the same binary still runs on older machines
+__attribute__((target("avx2")))
+inline void levenshtein_lanes_avx2(std::string_view sequence, const uint8_t* bases, const int& la, const int& cap, int* scores)
+{
+    __m256i row[65];
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i capVector = _mm256_set1_epi8((char)cap);
+    for(int j = 0; j <= la; ++j){row[j] = _mm256_set1_epi8((char)MIN(j, cap));}
+    for(int i = 0; i < (int)sequence.length(); ++i)
+    {
+        const __m256i base = _mm256_set1_epi8(sequence[i]);
+        __m256i diagonal = row[0];
+        for(int j = 1; j <= la; ++j)
+        {
+            const __m256i patternBase = _mm256_loadu_si256((const __m256i*)(bases + (j-1) * laneBlockSize));
+            const __m256i substitution = _mm256_adds_epu8(diagonal, _mm256_andnot_si256(_mm256_cmpeq_epi8(patternBase, base), one));
+            const __m256i deletion = (j == la) ? row[j] : _mm256_adds_epu8(row[j], one);
+            const __m256i insertion = _mm256_adds_epu8(row[j-1], one);
+            diagonal = row[j];
+            row[j] = _mm256_min_epu8(_mm256_min_epu8(substitution, deletion), _mm256_min_epu8(insertion, capVector));
+        }
+    }
+    uint8_t laneScores[laneBlockSize];
+    _mm256_storeu_si256((__m256i*)laneScores, row[la]);
+    for(int lane = 0; lane < laneBlockSize; ++lane){scores[lane] = laneScores[lane];}
+}
+#endif
+
+enum laneKernel{SCALAR_LANES, SSE2_LANES, AVX2_LANES};
+inline laneKernel supported_lane_kernel()
+{
+#if defined(__x86_64__)
+    static const laneKernel kernel = __builtin_cpu_supports("avx2") ? AVX2_LANES : SSE2_LANES;
+    return kernel;
+#else
+    return SCALAR_LANES;
+#endif
+}
+
+//kernels with compile-time pattern length La and mismatches K for windows of full length: loops are unrolled and only the band
+//of diagonals -K..K is calculated (like the banded levenshtein), cells left and right of the band count as K+1.
+//Since all values are capped at K+1 the scores are the same as of the generic kernels.
+//There are only kernels for mismatches that are aligned in lanes per read: with 0 mismatches the exact index decides, with 1 the 
+//edit-neighbourhood index answers all windows without N. With 2 the lanes are used once the neighbourhood index gets too large, with 3 always
+#define FIXED_LANE_KERNEL_MIN_LENGTH 6
+#define FIXED_LANE_KERNEL_MAX_LENGTH 16
+#define FIXED_LANE_KERNEL_MIN_MISMATCHES 2
+#define FIXED_LANE_KERNEL_MAX_MISMATCHES 3
+#if defined(__x86_64__)
+template<int La, int K>
+inline void levenshtein_lanes_sse2_fixed(std::string_view sequence, const uint8_t* bases, const int&, const int&, int* scores)
+{
+    __m128i row[La + 1];
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i capVector = _mm_set1_epi8(K + 1);
+    for(int half = 0; half < laneBlockSize; half += 16)
+    {
+#pragma GCC unroll 32
+        for(int j = 0; j <= La; ++j){row[j] = _mm_set1_epi8(MIN(j, K + 1));}
+#pragma GCC unroll 32
+        for(int i = 1; i <= La; ++i)
+        {
+            const __m128i base = _mm_set1_epi8(sequence[i-1]);
+            const int firstCol = MAX(1, i - K);
+            const int lastColumn = MIN(La, i + K);
+            __m128i diagonal = row[firstCol - 1];
+            __m128i left = (firstCol == 1) ? row[0] : capVector;
+#pragma GCC unroll 8
+            for(int j = firstCol; j <= lastColumn; ++j)
+            {
+                const __m128i patternBase = _mm_loadu_si128((const __m128i*)(bases + (j-1) * laneBlockSize + half));
+                const __m128i substitution = _mm_adds_epu8(diagonal, _mm_andnot_si128(_mm_cmpeq_epi8(patternBase, base), one));
+                const __m128i deletion = (j == La) ? row[j] : _mm_adds_epu8(row[j], one);
+                const __m128i insertion = _mm_adds_epu8(left, one);
+                diagonal = row[j];
+                row[j] = _mm_min_epu8(_mm_min_epu8(substitution, deletion), _mm_min_epu8(insertion, capVector));
+                left = row[j];
+            }
+        }
+        uint8_t laneScores[16];
+        _mm_storeu_si128((__m128i*)laneScores, row[La]);
+        for(int lane = 0; lane < 16; ++lane){scores[half + lane] = laneScores[lane];}
+    }
+}
+
+template<int La, int K>
+__attribute__((target("avx2")))
+inline void levenshtein_lanes_avx2_fixed(std::string_view sequence, const uint8_t* bases, const int&, const int&, int* scores)
+{
+    __m256i row[La + 1];
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i capVector = _mm256_set1_epi8(K + 1);
+#pragma GCC unroll 32
+    for(int j = 0; j <= La; ++j){row[j] = _mm256_set1_epi8(MIN(j, K + 1));}
+#pragma GCC unroll 32
+    for(int i = 1; i <= La; ++i)
+    {
+        const __m256i base = _mm256_set1_epi8(sequence[i-1]);
+        const int firstCol = MAX(1, i - K);
+        const int lastColumn = MIN(La, i + K);
+        __m256i diagonal = row[firstCol - 1];
+        __m256i left = (firstCol == 1) ? row[0] : capVector;
+#pragma GCC unroll 8
+        for(int j = firstCol; j <= lastColumn; ++j)
+        {
+            const __m256i patternBase = _mm256_loadu_si256((const __m256i*)(bases + (j-1) * laneBlockSize));
+            const __m256i substitution = _mm256_adds_epu8(diagonal, _mm256_andnot_si256(_mm256_cmpeq_epi8(patternBase, base), one));
+            const __m256i deletion = (j == La) ? row[j] : _mm256_adds_epu8(row[j], one);
+            const __m256i insertion = _mm256_adds_epu8(left, one);
+            diagonal = row[j];
+            row[j] = _mm256_min_epu8(_mm256_min_epu8(substitution, deletion), _mm256_min_epu8(insertion, capVector));
+            left = row[j];
+        }
+    }
+    uint8_t laneScores[laneBlockSize];
+    _mm256_storeu_si256((__m256i*)laneScores, row[La]);
+    for(int lane = 0; lane < laneBlockSize; ++lane){scores[lane] = laneScores[lane];}
+}
+#endif
+
+//find the specialised kernel for pattern length la and mismatches by going down from <La, K> through all instantiations
+template<int La, int K>
+inline laneKernelFunction select_fixed_lane_kernel(const int& la, const int& mismatches, const laneKernel& kernel)
+{
+    if(la == La && mismatches == K)
+    {
+#if defined(__x86_64__)
+        if(kernel == AVX2_LANES){return levenshtein_lanes_avx2_fixed<La, K>;}
+        if(kernel == SSE2_LANES){return levenshtein_lanes_sse2_fixed<La, K>;}
+#endif
+        return nullptr;
+    }
+    if constexpr(K > FIXED_LANE_KERNEL_MIN_MISMATCHES)
+    {
+        return select_fixed_lane_kernel<La, K - 1>(la, mismatches, kernel);
+    }
+    else if constexpr(La > FIXED_LANE_KERNEL_MIN_LENGTH)
+    {
+        return select_fixed_lane_kernel<La - 1, FIXED_LANE_KERNEL_MAX_MISMATCHES>(la, mismatches, kernel);
+    }
+    return nullptr;
+}
+
+//set the specialised kernels for all groups of lanes (patterns of one length), groups of unusual length keep the generic kernel
+inline void specialise_pattern_lanes(std::vector<patternLanes>& laneGroups, const int& mismatches, const laneKernel& kernel = supported_lane_kernel())
+{
+    for(patternLanes& lanes : laneGroups)
+    {
+        lanes.fixedKernel = select_fixed_lane_kernel<FIXED_LANE_KERNEL_MAX_LENGTH, FIXED_LANE_KERNEL_MAX_MISMATCHES>(lanes.length, mismatches, kernel);
+        lanes.fixedMismatches = mismatches;
+    }
+}
+
+//align sequence against all patterns of lanes and report the best score (if <= mismatches), how many patterns have this score and 
+//the first of them, the backtracking for the position of the alignment is left to levenshtein for the winning pattern.
+//With uniqueScore >= 0 no other pattern can have the same or a lower score than a pattern with at most uniqueScore (see unique_score), 
+//the remaining blocks are then not aligned anymore
+inline void levenshtein_lanes(std::string_view sequence, const patternLanes& lanes, const int& mismatches, laneAlignmentResult& result,
+                              laneKernel kernel = supported_lane_kernel(), const int& uniqueScore = -1)
+{
+    result = laneAlignmentResult();
+    result.bestScore = mismatches + 1;
+    //the SIMD kernels store scores in bytes of at most 255 and the rows on the stack
+    if(mismatches >= 255 || lanes.length > 64){kernel = SCALAR_LANES;}
+
+    //use the kernel for this pattern length and mismatches if there is one (and the window is not cut by the end of the sequence)
+    laneKernelFunction fixedKernel = nullptr;
+    if( (lanes.fixedKernel != nullptr) && (mismatches == lanes.fixedMismatches) && ((int)sequence.length() == lanes.length) )
+    {
+        fixedKernel = lanes.fixedKernel;
+    }
+
+    int scores[laneBlockSize];
+    for(int laneStart = 0; laneStart < (int)lanes.patternIdx.size(); laneStart += laneBlockSize)
+    {
+        const uint8_t* blockBases = lanes.bases.data() + laneStart * lanes.length;
+#if defined(__x86_64__)
+        if(fixedKernel != nullptr){fixedKernel(sequence, blockBases, lanes.length, mismatches + 1, scores);}
+        else if(kernel == AVX2_LANES){levenshtein_lanes_avx2(sequence, blockBases, lanes.length, mismatches + 1, scores);}
+        else if(kernel == SSE2_LANES){levenshtein_lanes_sse2(sequence, blockBases, lanes.length, mismatches + 1, scores);}
+        else{levenshtein_lanes_scalar(sequence, blockBases, lanes.length, mismatches + 1, scores);}
+#else
+        levenshtein_lanes_scalar(sequence, blockBases, lanes.length, mismatches + 1, scores);
+#endif
+        const int usedLanes = MIN(laneBlockSize, (int)lanes.patternIdx.size() - laneStart);
+        for(int lane = 0; lane < usedLanes; ++lane)
+        {
+            if(scores[lane] < result.bestScore)
+            {
+                result.bestScore = scores[lane];
+                result.bestCount = 1;
+                result.bestIdx = lanes.patternIdx[laneStart + lane];
+            }
+            else if(scores[lane] == result.bestScore && scores[lane] <= mismatches)
+            {
+                ++result.bestCount;
+            }
+        }
+        if(result.bestScore <= uniqueScore){return;}
+    }
+}
+
+inline int backBarcodeMappingExtension(std::string_view sequence, std::string_view pattern, int seq_end, const int& patternEnd)
 {
     int elongation = 0;
     //check if the end of sequebnces still maps for deletions
@@ -422,7 +1110,7 @@ inline int backBarcodeMappingExtension(const std::string& sequence, const std::s
     return elongation;
 }
 
-inline int frontBarcodeMappingExtension(const std::string& sequence, const std::string& pattern, const int& seq_start, const int& patternStart)
+inline int frontBarcodeMappingExtension(std::string_view sequence, std::string_view pattern, const int& seq_start, const int& patternStart)
 {
     int elongation = 0;
     //check if the end of sequebnces still maps for deletions
@@ -0,0 +1,702 @@
+//checks of the alignment kernels against a plain edit-matrix (or the generic kernels): random windows (also with N and cut by the end
+//of a read) are scored with every kernel and must give the same results, the program fails if one of the checks fails
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Barcode.hpp"
+
+static int failedChecks = 0;
+
+static void check(const bool& condition, const std::string& description)
+{
+    if(!condition)
+    {
+        ++failedChecks;
+        if(failedChecks <= 20){std::cerr << "FAILED: " << description << "\n";}
+    }
+}
+
+//edit distance of levenshtein: the whole pattern is aligned, deletions at the beginning and end of the sequence are free
+static int reference_score(std::string_view sequence, std::string_view pattern)
+{
+    const int ls = sequence.length();
+    const int la = pattern.length();
+    std::vector<int> row(la + 1);
+    for(int j = 0; j <= la; ++j){row[j] = j;}
+    for(int i = 1; i <= ls; ++i)
+    {
+        int diagonal = row[0];
+        row[0] = 0;
+        for(int j = 1; j <= la; ++j)
+        {
+            const int substitution = diagonal + ((sequence[i-1] == pattern[j-1]) ? 0 : 1);
+            const int deletion = row[j] + ((j == la) ? 0 : 1);
+            const int insertion = row[j-1] + 1;
+            diagonal = row[j];
+            row[j] = MIN(MIN(substitution, deletion), insertion);
+        }
+    }
+    return row[la];
+}
+
+static std::string random_sequence(std::mt19937& generator, const int& length, const double& nFraction = 0)
+{
+    std::uniform_int_distribution<int> baseDistribution(0, 3);
+    std::uniform_real_distribution<double> nDistribution(0, 1);
+    std::string sequence;
+    for(int i = 0; i < length; ++i)
+    {
+        sequence += (nDistribution(generator) < nFraction) ? 'N' : "ACGT"[baseDistribution(generator)];
+    }
+    return sequence;
+}
+
+//a pattern with up to edits random substitutions, insertions and deletions, like a read window of it
+static std::string mutate(std::mt19937& generator, std::string sequence, const int& edits)
+{
+    std::uniform_int_distribution<int> editDistribution(0, 2);
+    for(int edit = 0; edit < edits && !sequence.empty(); ++edit)
+    {
+        std::uniform_int_distribution<int> positionDistribution(0, sequence.length() - 1);
+        const int position = positionDistribution(generator);
+        const int type = editDistribution(generator);
+        if(type == 0){sequence[position] = "ACGTN"[std::uniform_int_distribution<int>(0, 4)(generator)];}
+        else if(type == 1){sequence.insert(sequence.begin() + position, "ACGT"[std::uniform_int_distribution<int>(0, 3)(generator)]);}
+        else{sequence.erase(position, 1);}
+    }
+    return sequence;
+}
+
+//a window of the read as VariableBarcode aligns it: a (mutated) pattern or random bases, followed by the read and cut to the pattern length,
+//sometimes cut shorter by the end of the read
+static std::string random_window(std::mt19937& generator, const std::vector<std::string>& patterns, const int& length, const int& mismatches)
+{
+    std::uniform_int_distribution<int> choice(0, 9);
+    std::string window;
+    const int type = choice(generator);
+    if(type < 7)
+    {
+        const std::string& pattern = patterns.at(std::uniform_int_distribution<int>(0, patterns.size() - 1)(generator));
+        window = mutate(generator, pattern, std::uniform_int_distribution<int>(0, mismatches + 1)(generator));
+    }
+    window += random_sequence(generator, length, (type == 9) ? 0.2 : 0.02);
+    window.resize(length);
+    if(choice(generator) == 0){window.resize(std::uniform_int_distribution<int>(0, length)(generator));}
+    return window;
+}
+
+//best score, number of patterns with this score and the first of them, as levenshtein_lanes reports them
+static laneAlignmentResult reference_lanes(std::string_view window, const std::vector<std::string>& patterns, const patternLanes& lanes,
+                                           const int& mismatches)
+{
+    laneAlignmentResult result;
+    result.bestScore = mismatches + 1;
+    for(const int& patternIdx : lanes.patternIdx)
+    {
+        const int score = reference_score(window, patterns.at(patternIdx));
+        if(score < result.bestScore)
+        {
+            result.bestScore = score;
+            result.bestCount = 1;
+            result.bestIdx = patternIdx;
+        }
+        else if(score == result.bestScore && score <= mismatches)
+        {
+            ++result.bestCount;
+        }
+    }
+    return result;
+}
+
+static bool same_result(const laneAlignmentResult& a, const laneAlignmentResult& b)
+{
+    return (a.bestScore == b.bestScore) && (a.bestCount == b.bestCount) && (a.bestCount == 0 || a.bestIdx == b.bestIdx);
+}
+
+static std::string describe(std::string_view window, const int& mismatches, const laneAlignmentResult& result, const laneAlignmentResult& expected)
+{
+    return std::string(window) + " (mismatches " + std::to_string(mismatches) + "): score " + std::to_string(result.bestScore) + " count " +
+           std::to_string(result.bestCount) + " idx " + std::to_string(result.bestIdx) + ", expected score " + std::to_string(expected.bestScore) +
+           " count " + std::to_string(expected.bestCount) + " idx " + std::to_string(expected.bestIdx);
+}
+
+//the bit-parallel levenshtein against the edit-matrix of levenshtein_matrix: patterns of up to 64 bases in sequences with N and edits,
+//windows cut by the end of the read and windows not longer than the pattern (banded with upperBoundCheck). Besides the score the 
+//positions of the backtracking must be the same, which also checks the del > subst > ins preference for equal scores
+static void check_bitparallel_levenshtein(std::mt19937& generator)
+{
+    //mismatches are always less than the pattern length (like for the barcodes of the tools)
+    for(const int& length : {1, 4, 8, 13, 20, 31, 32, 33, 50, 63, 64})
+    {
+        for(int sequenceNumber = 0; sequenceNumber < 400; ++sequenceNumber)
+        {
+            const int mismatches = std::uniform_int_distribution<int>(0, MIN(4, length - 1))(generator);
+            const std::string pattern = random_sequence(generator, length, (sequenceNumber % 10 == 0) ? 0.05 : 0);
+            std::string sequence = mutate(generator, pattern, std::uniform_int_distribution<int>(0, mismatches + 1)(generator));
+            const int type = sequenceNumber % 4;
+            if(type == 0)
+            {
+                //a window like the barcodes are aligned: the pattern followed by the read, cut to (at most) the pattern length
+                sequence += random_sequence(generator, length, 0.02);
+                sequence.resize(std::uniform_int_distribution<int>(MAX(0, length - mismatches - 1), length)(generator));
+            }
+            else if(type == 1)
+            {
+                //the pattern somewhere in a read, cut by the end of the read
+                sequence = random_sequence(generator, std::uniform_int_distribution<int>(0, 20)(generator), 0.02) + sequence;
+                sequence.resize(std::uniform_int_distribution<int>(0, sequence.length())(generator));
+            }
+            else
+            {
+                sequence = random_sequence(generator, std::uniform_int_distribution<int>(0, 20)(generator), 0.02) + sequence + 
+                           random_sequence(generator, std::uniform_int_distribution<int>(0, 20)(generator), 0.02);
+            }
+            for(const bool& upperBoundCheck : {false, true})
+            {
+                int start = -1, end = -1, score = -1, endInPattern = -1, startInPattern = -1;
+                int expectedStart = -1, expectedEnd = -1, expectedScore = -1, expectedEndInPattern = -1, expectedStartInPattern = -1;
+                const bool mapped = levenshtein_bitparallel(sequence, pattern, mismatches, start, end, score, endInPattern, startInPattern, upperBoundCheck);
+                const bool expectedMapped = levenshtein_matrix(sequence, pattern, mismatches, expectedStart, expectedEnd, expectedScore, 
+                                                               expectedEndInPattern, expectedStartInPattern, upperBoundCheck);
+                const bool samePositions = (start == expectedStart) && (end == expectedEnd) && (endInPattern == expectedEndInPattern) && 
+                                           (startInPattern == expectedStartInPattern);
+                check( (mapped == expectedMapped) && (!mapped || ((score == expectedScore) && samePositions)),
+                       "bit-parallel levenshtein of " + pattern + " in " + sequence + " (mismatches " + std::to_string(mismatches) + 
+                       (upperBoundCheck ? ", upper bound" : "") + "): mapped " + std::to_string(mapped) + " score " + std::to_string(score) + 
+                       " match " + std::to_string(start) + "-" + std::to_string(end) + " pattern " + std::to_string(startInPattern) + "-" + 
+                       std::to_string(endInPattern) + ", expected mapped " + std::to_string(expectedMapped) + " score " + std::to_string(expectedScore) + 
+                       " match " + std::to_string(expectedStart) + "-" + std::to_string(expectedEnd) + " pattern " + 
+                       std::to_string(expectedStartInPattern) + "-" + std::to_string(expectedEndInPattern));
+            }
+        }
+    }
+}
+
+//a read of random bases with some mutated copies of the linkers planted in it (also at the very beginning of the read)
+static std::string read_with_linkers(std::mt19937& generator, const std::vector<std::string>& linkers, const int& length, const int& edits)
+{
+    std::string read = random_sequence(generator, length, 0.02);
+    const int plantedLinkers = std::uniform_int_distribution<int>(0, 3)(generator);
+    for(int linkerNumber = 0; linkerNumber < plantedLinkers; ++linkerNumber)
+    {
+        const std::string& linker = linkers.at(std::uniform_int_distribution<int>(0, linkers.size() - 1)(generator));
+        const std::string planted = mutate(generator, linker, std::uniform_int_distribution<int>(0, edits)(generator));
+        const int position = (linkerNumber == 0 && std::uniform_int_distribution<int>(0, 2)(generator) == 0) ? 
+                             std::uniform_int_distribution<int>(0, linker.length() + edits)(generator) : 
+                             std::uniform_int_distribution<int>(0, read.length())(generator);
+        read.replace(MIN(position, (int)read.length()), planted.length(), planted);
+    }
+    read.resize(length);
+    return read;
+}
+
+//the search of a linker in a long read (levenshtein_search and LinkerAnchorSearch::find with the scan of the whole read) against 
+//levenshtein: reads with planted linkers, hits within the first length + mismatches bases (realigned by find) and reads shorter than the 
+//margin of the search, which are aligned directly
+static void check_linker_search(std::mt19937& generator)
+{
+    const std::vector<std::string> linkers = {random_sequence(generator, 8), random_sequence(generator, 15), random_sequence(generator, 20),
+                                              random_sequence(generator, 30), random_sequence(generator, 64)};
+    const LinkerAnchorSearch anchorSearch(linkers);
+    for(int readNumber = 0; readNumber < 3000; ++readNumber)
+    {
+        const int mismatches = std::uniform_int_distribution<int>(0, 4)(generator);
+        const int length = (readNumber % 5 == 0) ? std::uniform_int_distribution<int>(0, 40)(generator) 
+                                                 : std::uniform_int_distribution<int>(40, 300)(generator);
+        const std::string read = read_with_linkers(generator, linkers, length, mismatches + 1);
+        linkerScores scan;
+        anchorSearch.scan(read, scan);
+        for(const std::string& linker : linkers)
+        {
+            int expectedStart = -1, expectedEnd = -1, expectedScore = -1, expectedEndInPattern = -1, expectedStartInPattern = -1;
+            const bool expectedMapped = levenshtein(read, linker, mismatches, expectedStart, expectedEnd, expectedScore, 
+                                                    expectedEndInPattern, expectedStartInPattern, true);
+            int start = -1, end = -1, score = -1, endInPattern = -1, startInPattern = -1;
+            const bool mapped = levenshtein_search(read, linker, mismatches, start, end, score, endInPattern, startInPattern, true);
+            check( (mapped == expectedMapped) && (!mapped || ((score == expectedScore) && (start == expectedStart) && (end == expectedEnd) &&
+                   (endInPattern == expectedEndInPattern) && (startInPattern == expectedStartInPattern))),
+                   "levenshtein_search of " + linker + " in " + read + " (mismatches " + std::to_string(mismatches) + ")");
+
+            //find in the read from some offset on, with the scan of the whole read
+            const int readOffset = (readNumber % 3 == 0) ? 0 : std::uniform_int_distribution<int>(0, read.length())(generator);
+            const std::string_view sequence = std::string_view(read).substr(readOffset);
+            expectedStart = expectedEnd = expectedScore = expectedEndInPattern = expectedStartInPattern = -1;
+            const bool expectedFound = levenshtein(sequence, linker, mismatches, expectedStart, expectedEnd, expectedScore, 
+                                                   expectedEndInPattern, expectedStartInPattern, true);
+            start = end = score = endInPattern = startInPattern = -1;
+            const bool found = anchorSearch.find(scan, anchorSearch.linker_index(linker), sequence, readOffset, mismatches, 
+                                                 start, end, score, endInPattern, startInPattern);
+            check( (found == expectedFound) && (!found || ((score == expectedScore) && (start == expectedStart) && (end == expectedEnd) &&
+                   (endInPattern == expectedEndInPattern) && (startInPattern == expectedStartInPattern))),
+                   "anchor search of " + linker + " in " + std::string(sequence) + " (offset " + std::to_string(readOffset) + 
+                   ", mismatches " + std::to_string(mismatches) + ")");
+        }
+    }
+}
+
+//last column of the edit-matrix of linker in read (free start in the read, no free deletions at the end) for every position of the read
+static std::vector<int> reference_last_column(std::string_view read, std::string_view linker)
+{
+    const int ls = read.length();
+    const int la = linker.length();
+    std::vector<int> row(la + 1);
+    std::vector<int> lastColumn(ls + 1);
+    for(int j = 0; j <= la; ++j){row[j] = j;}
+    lastColumn[0] = la;
+    for(int i = 1; i <= ls; ++i)
+    {
+        int diagonal = row[0];
+        row[0] = 0;
+        for(int j = 1; j <= la; ++j)
+        {
+            const int substitution = diagonal + ((read[i-1] == linker[j-1]) ? 0 : 1);
+            diagonal = row[j];
+            row[j] = MIN(MIN(substitution, row[j] + 1), row[j-1] + 1);
+        }
+        lastColumn[i] = row[la];
+    }
+    return lastColumn;
+}
+
+//the scan of several linkers packed into one word against the edit-matrix and against the scan of every linker alone: linkers of 
+//different lengths that fill words up to (nearly) 64 bits, so that carries and horizontal differences would reach the next linker.
+//contains must agree with levenshtein within the mismatches
+static void check_packed_linker_scan(std::mt19937& generator)
+{
+    const std::vector<std::vector<int> > linkerLengthSets = { {20, 22, 20}, {31, 32}, {1, 62}, {5, 9, 13, 7, 11, 3, 8}, {64, 40, 23, 6, 17}, {12, 12, 12, 12, 12} };
+    for(const std::vector<int>& linkerLengths : linkerLengthSets)
+    {
+        std::vector<std::string> linkers;
+        for(const int& length : linkerLengths){linkers.push_back(random_sequence(generator, length));}
+        const LinkerAnchorSearch anchorSearch(linkers);
+        std::vector<LinkerAnchorSearch> singleSearches;
+        for(const std::string& linker : linkers){singleSearches.emplace_back(std::vector<std::string>{linker});}
+        for(int readNumber = 0; readNumber < 300; ++readNumber)
+        {
+            const int length = std::uniform_int_distribution<int>(0, 200)(generator);
+            const std::string read = read_with_linkers(generator, linkers, length, 3);
+            linkerScores scan;
+            anchorSearch.scan(read, scan);
+            for(int linkerIdx = 0; linkerIdx < (int)linkers.size(); ++linkerIdx)
+            {
+                const std::string& linker = linkers.at(linkerIdx);
+                const int scoreIdx = anchorSearch.linker_index(linker);
+                const std::vector<int> expected = reference_last_column(read, linker);
+                linkerScores singleScan;
+                singleSearches.at(linkerIdx).scan(read, singleScan);
+                bool sameScores = true;
+                for(int i = 0; i <= (int)read.length(); ++i)
+                {
+                    const int score = scan.scores.at(scoreIdx * (read.length() + 1) + i);
+                    sameScores = sameScores && (score == expected.at(i)) && (singleScan.scores.at(i) == expected.at(i));
+                }
+                check(sameScores, "packed scan of " + linker + " in " + read);
+
+                for(const int& mismatches : {0, 1, 2, 3})
+                {
+                    if(mismatches >= (int)linker.length()){continue;}
+                    int start, end, score, endInPattern, startInPattern;
+                    const bool expectedContained = levenshtein(read, linker, mismatches, start, end, score, endInPattern, startInPattern);
+                    check(anchorSearch.contains(read, scoreIdx, mismatches) == expectedContained, 
+                          "linker " + linker + " contained in " + read + " (mismatches " + std::to_string(mismatches) + ")");
+                }
+            }
+        }
+    }
+}
+
+//edit distance of the whole sequence to the whole pattern (no free deletions), like UMIs are compared
+static int reference_global_score(std::string_view sequence, std::string_view pattern)
+{
+    const int la = pattern.length();
+    std::vector<int> row(la + 1);
+    for(int j = 0; j <= la; ++j){row[j] = j;}
+    for(int i = 1; i <= (int)sequence.length(); ++i)
+    {
+        int diagonal = row[0];
+        row[0] = i;
+        for(int j = 1; j <= la; ++j)
+        {
+            const int substitution = diagonal + ((sequence[i-1] == pattern[j-1]) ? 0 : 1);
+            diagonal = row[j];
+            row[j] = MIN(MIN(substitution, row[j] + 1), row[j-1] + 1);
+        }
+    }
+    return row[la];
+}
+
+//lcp (16 and 8 bytes at once) against comparing base by base, and outputSense against the edit-matrix: random UMI pairs of lengths
+//around 8 and 16 bases with edits, mismatches up to and beyond their distance so that outputSense also stops at the mismatches
+static void check_output_sense(std::mt19937& generator)
+{
+    for(int pairNumber = 0; pairNumber < 20000; ++pairNumber)
+    {
+        const int length = std::uniform_int_distribution<int>(1, 40)(generator);
+        const std::string umi = random_sequence(generator, length, 0.02);
+        const std::string otherUmi = mutate(generator, umi, std::uniform_int_distribution<int>(0, 4)(generator));
+
+        unsigned int expectedLcp = 0;
+        while( (expectedLcp < MIN(umi.length(), otherUmi.length())) && (umi[expectedLcp] == otherUmi[expectedLcp]) ){++expectedLcp;}
+        check(lcp(umi, otherUmi) == expectedLcp, "lcp of " + umi + " and " + otherUmi);
+
+        if(otherUmi.empty()){continue;}
+        const int distance = reference_global_score(otherUmi, umi);
+        for(const int& mismatches : {0, 1, 2, 3, 5})
+        {
+            int score = -1;
+            const bool mapped = outputSense(otherUmi, umi, mismatches, score);
+            const int expectedScore = (distance <= mismatches) ? distance : (mismatches + 1);
+            check( (mapped == (distance <= mismatches)) && (score == expectedScore),
+                   "outputSense of " + otherUmi + " and " + umi + " (mismatches " + std::to_string(mismatches) + "): score " + 
+                   std::to_string(score) + ", expected " + std::to_string(expectedScore));
+        }
+    }
+}
+
+//the scalar, SSE2 and AVX2 lane kernels and the scalar levenshtein against the edit-matrix
+static void check_lane_kernels(std::mt19937& generator)
+{
+    std::vector<laneKernel> kernels = {SCALAR_LANES};
+#if defined(__x86_64__)
+    kernels.push_back(SSE2_LANES);
+    if(supported_lane_kernel() == AVX2_LANES){kernels.push_back(AVX2_LANES);}
+#endif
+    const std::vector<std::string> kernelNames = {"scalar", "SSE2", "AVX2"};
+    for(const int& length : {4, 8, 12, 16, 25, 64})
+    {
+        for(const int& patternNumber : {1, 7, 32, 45})
+        {
+            //patterns of one length (also some of another length, which get their own group of lanes)
+            std::vector<std::string> patterns;
+            for(int i = 0; i < patternNumber; ++i){patterns.push_back(random_sequence(generator, (i % 5 == 4) ? length + 1 : length));}
+            const std::vector<patternLanes> laneGroups = generate_pattern_lanes(patterns);
+            for(const int& mismatches : {0, 1, 2, 3, 5})
+            {
+                for(int windowNumber = 0; windowNumber < 200; ++windowNumber)
+                {
+                    for(const patternLanes& lanes : laneGroups)
+                    {
+                        const std::string window = random_window(generator, patterns, lanes.length, mismatches);
+                        const laneAlignmentResult expected = reference_lanes(window, patterns, lanes, mismatches);
+                        for(const laneKernel& kernel : kernels)
+                        {
+                            laneAlignmentResult result;
+                            levenshtein_lanes(window, lanes, mismatches, result, kernel);
+                            check(same_result(result, expected), kernelNames.at(kernel) + " lanes for " + describe(window, mismatches, result, expected));
+                        }
+                        for(const int& patternIdx : lanes.patternIdx)
+                        {
+                            int score = -1;
+                            const int expectedScore = reference_score(window, patterns.at(patternIdx));
+                            const bool mapped = levenshtein_score(window, patterns.at(patternIdx), mismatches, score, true);
+                            check((mapped == (expectedScore <= mismatches)) && (!mapped || score == expectedScore),
+                                  "levenshtein_score of " + window + " and " + patterns.at(patternIdx));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//the kernels specialised on pattern length and mismatches against the generic kernel of the same instruction set, for every lane of a block
+static void check_fixed_lane_kernels(std::mt19937& generator)
+{
+#if defined(__x86_64__)
+    std::vector<laneKernel> kernels = {SSE2_LANES};
+    if(supported_lane_kernel() == AVX2_LANES){kernels.push_back(AVX2_LANES);}
+    for(const laneKernel& kernel : kernels)
+    {
+        const laneKernelFunction genericKernel = (kernel == AVX2_LANES) ? levenshtein_lanes_avx2 : levenshtein_lanes_sse2;
+        for(int length = FIXED_LANE_KERNEL_MIN_LENGTH - 1; length <= FIXED_LANE_KERNEL_MAX_LENGTH + 1; ++length)
+        {
+            for(int mismatches = 0; mismatches <= FIXED_LANE_KERNEL_MAX_MISMATCHES + 1; ++mismatches)
+            {
+                const laneKernelFunction fixedKernel = 
+                    select_fixed_lane_kernel<FIXED_LANE_KERNEL_MAX_LENGTH, FIXED_LANE_KERNEL_MAX_MISMATCHES>(length, mismatches, kernel);
+                const bool specialised = (length >= FIXED_LANE_KERNEL_MIN_LENGTH) && (length <= FIXED_LANE_KERNEL_MAX_LENGTH) && 
+                                         (mismatches >= FIXED_LANE_KERNEL_MIN_MISMATCHES) && (mismatches <= FIXED_LANE_KERNEL_MAX_MISMATCHES);
+                check((fixedKernel != nullptr) == specialised, "specialised kernel for length " + std::to_string(length) + 
+                      " and mismatches " + std::to_string(mismatches));
+                if(fixedKernel == nullptr){continue;}
+
+                std::vector<std::string> patterns;
+                for(int i = 0; i < laneBlockSize; ++i){patterns.push_back(random_sequence(generator, length));}
+                const patternLanes lanes = generate_pattern_lanes(patterns).front();
+                for(int windowNumber = 0; windowNumber < 600; ++windowNumber)
+                {
+                    //the specialised kernels are only used for windows of full length
+                    std::string window = random_window(generator, patterns, length, mismatches);
+                    window += random_sequence(generator, length - window.length());
+                    int fixedScores[laneBlockSize];
+                    int genericScores[laneBlockSize];
+                    fixedKernel(window, lanes.bases.data(), length, mismatches + 1, fixedScores);
+                    genericKernel(window, lanes.bases.data(), length, mismatches + 1, genericScores);
+                    for(int lane = 0; lane < laneBlockSize; ++lane)
+                    {
+                        check(fixedScores[lane] == genericScores[lane], std::string((kernel == AVX2_LANES) ? "AVX2" : "SSE2") + 
+                              " specialised kernel for " + window + " and " + patterns.at(lane) + " (mismatches " + std::to_string(mismatches) + 
+                              "): " + std::to_string(fixedScores[lane]) + " instead of " + std::to_string(genericScores[lane]));
+                    }
+                }
+            }
+        }
+    }
+#endif
+}
+
+//whitelists of several lengths (every length is a group of lanes) with one group large enough for the indexes of large whitelists
+static std::vector<std::string> random_whitelist(std::mt19937& generator, const std::vector<int>& lengths, const int& largeGroupSize)
+{
+    std::vector<std::string> patterns;
+    for(int i = 0; i < largeGroupSize; ++i){patterns.push_back(random_sequence(generator, lengths.front()));}
+    for(int lengthIdx = 1; lengthIdx < (int)lengths.size(); ++lengthIdx)
+    {
+        for(int i = 0; i < 100; ++i){patterns.push_back(random_sequence(generator, lengths.at(lengthIdx)));}
+    }
+    std::shuffle(patterns.begin(), patterns.end(), generator);
+    return patterns;
+}
+
+//the minimal perfect hash must give every key of the set another value of 0..n-1, and the exact index built on it the same results as the 
+//edit-matrix with 0 mismatches: foreign windows (also with N or cut short) are rejected by comparing the key, patterns that are several
+//times in the whitelist give the number of occurences and their first index like the lanes
+static void check_exact_indexes(std::mt19937& generator)
+{
+    for(const int& keyNumber : {1, 10, 1000, 100000})
+    {
+        std::unordered_set<uint64_t> keySet;
+        std::uniform_int_distribution<uint64_t> keyDistribution;
+        while((int)keySet.size() < keyNumber){keySet.insert(keyDistribution(generator));}
+        const MinimalPerfectHash perfectHash(std::vector<uint64_t>(keySet.begin(), keySet.end()));
+        std::vector<bool> valueSeen(keyNumber, false);
+        bool minimalPerfect = true;
+        for(const uint64_t& key : keySet)
+        {
+            const int64_t value = perfectHash(key);
+            minimalPerfect = minimalPerfect && (value >= 0) && (value < keyNumber) && !valueSeen.at(value);
+            if(minimalPerfect){valueSeen.at(value) = true;}
+        }
+        check(minimalPerfect, "minimal perfect hash of " + std::to_string(keyNumber) + " keys");
+        check((keyNumber < 1000) || (perfectHash.level_number() > 1), "levels of the minimal perfect hash of " + std::to_string(keyNumber) + " keys");
+    }
+
+    std::vector<std::string> patterns = random_whitelist(generator, {10, 6, 8, 14}, 3000);
+    //duplicated patterns: the index stores them once with their number
+    for(int duplicate = 0; duplicate < 200; ++duplicate)
+    {
+        patterns.push_back(patterns.at(std::uniform_int_distribution<int>(0, patterns.size() - 1)(generator)));
+    }
+    std::shuffle(patterns.begin(), patterns.end(), generator);
+    const std::vector<patternLanes> laneGroups = generate_pattern_lanes(patterns);
+    for(const patternLanes& lanes : laneGroups)
+    {
+        const ExactBarcodeIndex index(patterns, lanes.patternIdx, lanes.length);
+        for(int windowNumber = 0; windowNumber < 600; ++windowNumber)
+        {
+            //exact patterns (also the duplicated ones) and random windows of random_window
+            std::string window = (windowNumber % 2 == 0) ? patterns.at(lanes.patternIdx.at(windowNumber % lanes.patternIdx.size()))
+                                                         : random_window(generator, patterns, lanes.length, 1);
+            const laneAlignmentResult expected = reference_lanes(window, patterns, lanes, 0);
+            laneAlignmentResult result;
+            index.lookup(window, result);
+            //without an exact match the index leaves the score unset (the window is aligned afterwards)
+            check( (result.bestCount == expected.bestCount) && ((result.bestCount == 0) || ((result.bestScore == 0) && (result.bestIdx == expected.bestIdx))),
+                   "exact index for " + describe(window, 0, result, expected));
+        }
+    }
+}
+
+//the sequence of ACGT with the 2-bit codes of packed (first base in the lowest bits)
+static std::string unpack_window(const int& packed, const int& length)
+{
+    std::string window;
+    for(int i = 0; i < length; ++i){window += "ACGT"[(packed >> (2 * i)) & 3];}
+    return window;
+}
+
+//the lane search that stops at a pattern within the unique score of the whitelist against the edit-matrix of all patterns: whitelists of
+//one length with small and larger minimum distances (a hit within the unique score must be the only best pattern). The pair of patterns
+//has a window with distance s to one and at most s to the other pattern although their distance is 2*s+3
+static void check_unique_score(std::mt19937& generator)
+{
+    std::vector<std::vector<std::string> > whitelists = {{"TAGCCAG", "CCTTATT"}};
+    for(const int& length : {6, 7, 10, 16, 24})
+    {
+        for(const int& patternNumber : {5, 40, 200})
+        {
+            whitelists.push_back(random_whitelist(generator, {length}, patternNumber));
+        }
+    }
+    int checkedWhitelists = 0;
+    for(const std::vector<std::string>& patterns : whitelists)
+    {
+        const int length = patterns.front().length();
+        const std::vector<patternLanes> laneGroups = generate_pattern_lanes(patterns);
+        for(const int& mismatches : {1, 2, 3})
+        {
+            const int uniqueScore = unique_score(analyse_whitelist(patterns, mismatches), mismatches);
+            if(uniqueScore < 0){continue;}
+            ++checkedWhitelists;
+            //all windows of ACGT for short patterns in small whitelists, random windows (with N and cut short) otherwise
+            const bool allWindows = (length <= 7) && (patterns.size() <= 40);
+            const int windowNumber = allWindows ? (1 << (2 * length)) : 1000;
+            for(int windowIdx = 0; windowIdx < windowNumber; ++windowIdx)
+            {
+                const std::string window = allWindows ? unpack_window(windowIdx, length) : random_window(generator, patterns, length, mismatches);
+                const laneAlignmentResult expected = reference_lanes(window, patterns, laneGroups.front(), mismatches);
+                check((expected.bestScore > uniqueScore) || (expected.bestCount == 1), 
+                      "unique score " + std::to_string(uniqueScore) + " for " + describe(window, mismatches, expected, expected));
+                laneAlignmentResult result;
+                levenshtein_lanes(window, laneGroups.front(), mismatches, result, supported_lane_kernel(), uniqueScore);
+                check(same_result(result, expected), "lanes with unique score " + std::to_string(uniqueScore) + " for " + 
+                      describe(window, mismatches, result, expected));
+            }
+        }
+    }
+    check(checkedWhitelists > 10, "whitelists with a unique score");
+}
+
+//the seed index of every group of patterns against the edit-matrix of all patterns of the group
+static void check_seed_indexes(std::mt19937& generator)
+{
+    const std::vector<std::string> patterns = random_whitelist(generator, {12, 8, 10, 16}, SEED_INDEX_MIN_PATTERNS + 500);
+    const std::vector<patternLanes> laneGroups = generate_pattern_lanes(patterns);
+    for(const int& mismatches : {1, 2, 3})
+    {
+        //the large group gets a seed index as in VariableBarcode if the seeds are long enough (patterns of 12 bases with 1 mismatch),
+        //the indexes of the other groups are checked anyway
+        const std::vector<SeedCandidateIndexPtr> seedIndexes = 
+            generate_seed_indexes(patterns, laneGroups, std::vector<EditNeighbourhoodIndexPtr>(laneGroups.size(), nullptr), mismatches);
+        for(int groupIdx = 0; groupIdx < (int)laneGroups.size(); ++groupIdx)
+        {
+            const patternLanes& lanes = laneGroups.at(groupIdx);
+            check((seedIndexes.at(groupIdx) != nullptr) == ((int)lanes.patternIdx.size() >= SEED_INDEX_MIN_PATTERNS && mismatches == 1),
+                  "seed index for " + std::to_string(lanes.patternIdx.size()) + " patterns of length " + std::to_string(lanes.length));
+            const SeedCandidateIndex index(patterns, lanes.patternIdx, lanes.length, mismatches);
+            for(int windowNumber = 0; windowNumber < 300; ++windowNumber)
+            {
+                const std::string window = random_window(generator, patterns, lanes.length, mismatches);
+                const laneAlignmentResult expected = reference_lanes(window, patterns, lanes, mismatches);
+                laneAlignmentResult result;
+                index.lookup(window, result);
+                check(same_result(result, expected), "seed index for " + describe(window, mismatches, result, expected));
+            }
+        }
+    }
+}
+
+//the trie of every group of patterns against the edit-matrix: windows up to the pattern length with up to 2 mismatches are searched 
+//with the Levenshtein automaton, longer windows and more mismatches with the DP columns
+static void check_pattern_tries(std::mt19937& generator)
+{
+    const std::vector<std::string> patterns = random_whitelist(generator, {10, 6, 8, 14}, PATTERN_TRIE_MIN_PATTERNS + 200);
+    const std::vector<patternLanes> laneGroups = generate_pattern_lanes(patterns);
+    for(const int& mismatches : {0, 1, 2, 3})
+    {
+        for(const patternLanes& lanes : laneGroups)
+        {
+            check(PatternTrie::applicable(patterns, lanes.patternIdx, lanes.length, mismatches) == 
+                  ((int)lanes.patternIdx.size() >= PATTERN_TRIE_MIN_PATTERNS), "trie for " + std::to_string(lanes.patternIdx.size()) + " patterns");
+            const PatternTrie trie(patterns, lanes.patternIdx, lanes.length, mismatches);
+            for(int windowNumber = 0; windowNumber < 300; ++windowNumber)
+            {
+                std::string window = random_window(generator, patterns, lanes.length, mismatches);
+                if(windowNumber % 5 == 0){window += random_sequence(generator, 1 + windowNumber % 3);}
+                const laneAlignmentResult expected = reference_lanes(window, patterns, lanes, mismatches);
+                laneAlignmentResult result;
+                trie.lookup(window, result);
+                check(same_result(result, expected), "trie for " + describe(window, mismatches, result, expected));
+            }
+        }
+    }
+}
+
+//the packed Hamming distance against counting differing characters: windows with N (which differs from every base) against random patterns
+//of up to 32 bases
+static void check_packed_hamming(std::mt19937& generator)
+{
+    for(const int& length : {1, 7, 16, 31, 32})
+    {
+        for(int windowNumber = 0; windowNumber < 300; ++windowNumber)
+        {
+            const std::string pattern = random_sequence(generator, length);
+            const std::string window = random_sequence(generator, length, 0.1) + random_sequence(generator, windowNumber % 3);
+            int expected = 0;
+            for(int i = 0; i < length; ++i){expected += (window[i] != pattern[i]) ? 1 : 0;}
+            uint64_t packedPattern = 0;
+            uint64_t packedWindow = 0;
+            uint64_t nMask = 0;
+            check(pack_kmer(pattern, packedPattern), "packing of " + pattern);
+            pack_kmer_with_n_mask(window, length, packedWindow, nMask);
+            check(kmer_hamming_distance(packedWindow, packedPattern, nMask) == expected, "packed Hamming distance of " + window + " to " + pattern);
+        }
+    }
+}
+
+//a variable barcode matched with the Levenshtein automaton against the same barcode matched with the alignment: reads with the barcode
+//(with edits and N) at some offset are matched forward and reverse, with and without start correction, all results must be the same
+static void check_automaton_barcodes(std::mt19937& generator)
+{
+    const std::vector<std::string> patterns = random_whitelist(generator, {8, 7, 10}, 200);
+    for(const int& mismatches : {0, 1, 2})
+    {
+        VariableBarcode alignedBarcode(patterns, mismatches);
+        VariableBarcode automatonBarcode(patterns, mismatches, matchingMode::LEVENSHTEIN_AUTOMATON);
+        check(mismatches == 0 || automatonBarcode.describe_matching_plan().find("Levenshtein automaton") != std::string::npos, 
+              "Levenshtein automaton for " + std::to_string(mismatches) + " mismatches");
+        for(int readNumber = 0; readNumber < 3000; ++readNumber)
+        {
+            const int offset = readNumber % 4;
+            std::string read = random_sequence(generator, offset);
+            read += random_window(generator, patterns, 12, mismatches) + random_sequence(generator, readNumber % 3 ? 6 : 0);
+            for(const bool& reverse : {false, true})
+            {
+                for(const bool& startCorrection : {false, true})
+                {
+                    matchResult alignedResult;
+                    matchResult automatonResult;
+                    alignedResult.differenceInBarcodeLength = automatonResult.differenceInBarcodeLength = readNumber % 3;
+                    alignedBarcode.match_pattern(read, offset, alignedResult, startCorrection, reverse);
+                    automatonBarcode.match_pattern(read, offset, automatonResult, startCorrection, reverse);
+                    check( (alignedResult.matched == automatonResult.matched) && (!alignedResult.matched || 
+                           ( (alignedResult.seq_start == automatonResult.seq_start) && (alignedResult.seq_end == automatonResult.seq_end) && 
+                             (alignedResult.score == automatonResult.score) && (alignedResult.realBarcode == automatonResult.realBarcode) &&
+                             (alignedResult.differenceInBarcodeLength == automatonResult.differenceInBarcodeLength) )),
+                           "Levenshtein automaton for read " + read + " at offset " + std::to_string(offset) + " (mismatches " + 
+                           std::to_string(mismatches) + "): " + std::string(automatonResult.realBarcode) + " instead of " + 
+                           std::string(alignedResult.realBarcode));
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    std::mt19937 generator(42);
+    check_output_sense(generator);
+    check_bitparallel_levenshtein(generator);
+    check_linker_search(generator);
+    check_packed_linker_scan(generator);
+    check_lane_kernels(generator);
+    check_fixed_lane_kernels(generator);
+    check_exact_indexes(generator);
+    check_unique_score(generator);
+    check_seed_indexes(generator);
+    check_pattern_tries(generator);
+    check_automaton_barcodes(generator);
+    check_packed_hamming(generator);
+
+    if(failedChecks > 0)
+    {
+        std::cerr << std::to_string(failedChecks) << " CHECKS OF THE ALIGNMENT KERNELS FAILED\n";
+        return 1;
+    }
+    std::cout << "ALL CHECKS OF THE ALIGNMENT KERNELS PASSED\n";
+    return 0;
+}
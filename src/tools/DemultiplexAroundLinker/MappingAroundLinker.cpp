@@ -72,18 +72,15 @@ void MappingAroundLinker<MappingPolicy, FilePolicy>::initialize_output_files(con
 
 
 /**
-* @brief function wrapping the demultiplex_read function of the Mapping class to increment and decrement a counter of elements
-* in the current queue. Used to allow processing of only a few lines a time instead of writing all into RAM.
+* @brief function wrapping the demultiplex_read function of the Mapping class, called for every read of a batch in the thread pool.
 **/
 template <typename MappingPolicy, typename FilePolicy>
 void MappingAroundLinker<MappingPolicy, FilePolicy>::demultiplex_wrapper(std::pair<const std::string&, const std::string&> line,
                                                             const input& input,
                                                             std::atomic<unsigned long long>& lineCount,
-                                                            const unsigned long long& totalReadCount,
-                                                            std::atomic<long long int>& elementsInQueue)
+                                                            const unsigned long long& totalReadCount)
 {
     this->demultiplex_read(line, input, lineCount, totalReadCount, false);
-    --elementsInQueue;
 }
 
 /// overwritten run_mapping function to allow processing of only a subset of fastq lines at a time
@@ -92,28 +89,15 @@ void MappingAroundLinker<MappingPolicy, FilePolicy>::run_mapping(const input& in
 {
     std::cout << "START DEMULTIPLEXING OF IMPERFECT BARCODE SEQUENCES\n";
 
-    //generate a pool of threads
-    boost::asio::thread_pool pool(input.threads); //create thread pool
-
-    //read line by line and add to thread pool
+    //read the file in batches and map them in the thread pool, the number of reads in the queue is limited by the bucket size
     this->FilePolicy::init_file(input.inFile, input.reverseFile);
-    std::pair<std::string, std::string> line;
     std::atomic<unsigned long long> lineCount = 0; //using atomic<int> as thread safe read count
-    std::atomic<long long int> elementsInQueue = 0;
     unsigned long long totalReadCount = FilePolicy::get_read_number();
 
-    while(FilePolicy::get_next_line(line))
-    {
-        //wait to enqueue new elements in case we have a maximum bucket size
-        if(input.fastqReadBucketSize>0)
-        {
-            while(input.fastqReadBucketSize <= elementsInQueue){}
-        }
-        //increase job count and push the job in the queue
-        ++elementsInQueue;
-        boost::asio::post(pool, std::bind(&MappingAroundLinker::demultiplex_wrapper, this, line, input, std::ref(lineCount), totalReadCount, std::ref(elementsInQueue)));
-    }
-    pool.join();
+    this->map_reads_in_batches(input, [this, &input, &lineCount, &totalReadCount](std::pair<const std::string&, const std::string&> line)
+                               {
+                                   demultiplex_wrapper(line, input, lineCount, totalReadCount);
+                               });
     printProgress(1); std::cout << "\n"; // end the progress bar
     if(totalReadCount != ULLONG_MAX)
     {
@@ -121,6 +105,8 @@ void MappingAroundLinker<MappingPolicy, FilePolicy>::run_mapping(const input& in
                 << "% | MODERATE MATCHES: " << std::to_string((unsigned long long)(100*(this->get_moderat_matches())/(double)totalReadCount))
                 << "% | MISMATCHES: " << std::to_string((unsigned long long)(100*(this->get_failed_matches())/(double)totalReadCount)) << "%\n";
     }
+    this->print_result_cache_stats();
+    this->print_traceback_warnings();
 
     FilePolicy::close_file();
 }
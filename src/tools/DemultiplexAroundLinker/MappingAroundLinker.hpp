@@ -4,7 +4,7 @@
  * to store statistics, failes lines, etc
  * also this class allows to read only a subset of reads into RAM
  * and by that keeping the processing queue only filled up to a certain
- * level, once a task is finished the queue is filled with the next read
+ * level, once a batch of reads is mapped the queue is filled with the next batch
 **/
 template<typename MappingPolicy, typename FilePolicy>
 class MappingAroundLinker : private Mapping<MappingPolicy, FilePolicy>
@@ -14,8 +14,7 @@ class MappingAroundLinker : private Mapping<MappingPolicy, FilePolicy>
         void demultiplex_wrapper(std::pair<const std::string&, const std::string&> line,
                                 const input& input,
                                 std::atomic<unsigned long long>& lineCount,
-                                const unsigned long long& totalReadCount,
-                                std::atomic<long long int>& elementsInQueue);
+                                const unsigned long long& totalReadCount);
         void initialize_output_files(const input& input,const std::vector<std::pair<std::string, char> >& patterns);
         void run_mapping(const input& input);
 
@@ -1,30 +1,25 @@
 #include "DemultiplexedLinesWriter.hpp"
 
-/// creates new files for failed lines, mapped barcodes (and writes header), statistics
-void initialize_output(std::string output, const std::vector<std::pair<std::string, char> > patterns, 
-                       std::string& guideNameTage, bool initializeGuideFile = false, bool guideFileHasUmi = false)
+/// path of an output file: the file name of the output with a prefix (e.g. StatsMismatches_), in the directory of the output
+std::string prefixed_output_path(const std::string& output, const std::string& prefix)
 {
-    //remove output
-    std::string outputStats;
-    std::string outputMapped;
-    std::string outputFailed;
-    std::string outputGuide;
-
     std::size_t found = output.find_last_of("/");
     if(found == std::string::npos)
     {
-        outputMapped = "Demultiplexed_" + output;
-        outputStats = "StatsMismatches_" + output;
-        outputFailed = "FailedLines_" + output;
-        outputGuide = "Demultiplexed_" + guideNameTage + output;
-    }
-    else
-    {
-        outputMapped = output.substr(0,found) + "/" + "Demultiplexed_" + output.substr(found+1);
-        outputStats = output.substr(0,found) + "/" + "StatsMismatches_" + output.substr(found+1);
-        outputFailed = output.substr(0,found) + "/" + "FailedLines_" + output.substr(found+1);
-        outputGuide = output.substr(0,found) + "/" + "Demultiplexed_" + guideNameTage + output.substr(found+1);
+        return(prefix + output);
     }
+    return(output.substr(0,found) + "/" + prefix + output.substr(found+1));
+}
+
+/// creates new files for failed lines, mapped barcodes (and writes header), statistics
+void initialize_output(std::string output, const std::vector<std::pair<std::string, char> > patterns, 
+                       std::string& guideNameTage, bool initializeGuideFile = false, bool guideFileHasUmi = false)
+{
+    //remove output
+    std::string outputMapped = prefixed_output_path(output, "Demultiplexed_");
+    std::string outputStats = prefixed_output_path(output, "StatsMismatches_");
+    std::string outputFailed = prefixed_output_path(output, "FailedLines_");
+    std::string outputGuide = prefixed_output_path(output, "Demultiplexed_" + guideNameTage);
     // remove outputfile if it exists
     std::remove(outputMapped.c_str());
     std::remove(outputStats.c_str());
@@ -73,17 +68,8 @@ void initialize_output(std::string output, const std::vector<std::pair<std::stri
 /// write mismatches per barcode to file
 void write_stats(const input& input, const std::map<std::string, std::vector<int> >& statsMismatchDict)
 {
-    std::string output = input.outFile;
+    std::string output = prefixed_output_path(input.outFile, "StatsMismatches_");
     std::ofstream outputFile;
-    std::size_t found = output.find_last_of("/");
-    if(found == std::string::npos)
-    {
-        output = "StatsMismatches_" + output;
-    }
-    else
-    {
-        output = output.substr(0,found) + "/" + "StatsMismatches_" + output.substr(found+1);
-    }
     std::remove(output.c_str());
     outputFile.open (output, std::ofstream::app);
 
@@ -101,26 +87,26 @@ void write_stats(const input& input, const std::map<std::string, std::vector<int
     outputFile.close();
 }
 
+/// write the matching plan (whitelist properties and search used per barcode) to file
+void write_matching_plan(const input& input, const std::string& matchingPlan)
+{
+    std::string output = prefixed_output_path(input.outFile, "StatsMatchingPlan_");
+    std::ofstream outputFile;
+    std::remove(output.c_str());
+    outputFile.open (output, std::ofstream::app);
+    outputFile << matchingPlan;
+    outputFile.close();
+}
+
 /// write failed lines into a txt file
 void write_failed_line(const input& input, std::pair<const std::string&, const std::string&> failedLine)
 {
     if(failedLine.second.empty())
     {
-        std::string output = input.outFile;
         std::ofstream outputFile;
 
         //write real sequences that map to barcodes
-        std::size_t found = output.find_last_of("/");
-        std::string outputFail;
-        if(found == std::string::npos)
-        {
-            outputFail = "FailedLines_" + output;
-        }
-        else
-        {
-            outputFail = output.substr(0,found) + "/" + "FailedLines_" + output.substr(found+1);
-        }
-        outputFile.open (outputFail, std::ofstream::app);
+        outputFile.open (prefixed_output_path(input.outFile, "FailedLines_"), std::ofstream::app);
         
         outputFile << failedLine.first << "\n";
         
@@ -129,21 +115,10 @@ void write_failed_line(const input& input, std::pair<const std::string&, const s
     else
     {
         //write forward reads
-        std::string output = input.outFile;
         std::ofstream outputFile;
 
         //write real sequences that map to barcodes
-        std::size_t found = output.find_last_of("/");
-        std::string outputFail;
-        if(found == std::string::npos)
-        {
-            outputFail = "FailedLines_1_" + output;
-        }
-        else
-        {
-            outputFail = output.substr(0,found) + "/" + "FailedLines_1_" + output.substr(found+1);
-        }
-        outputFile.open (outputFail, std::ofstream::app);
+        outputFile.open (prefixed_output_path(input.outFile, "FailedLines_1_"), std::ofstream::app);
         
         outputFile << failedLine.first << "\n";
         
@@ -151,15 +126,7 @@ void write_failed_line(const input& input, std::pair<const std::string&, const s
 
         //write reverse reads
         //write real sequences that map to barcodes
-        if(found == std::string::npos)
-        {
-            outputFail = "FailedLines_2_" + output;
-        }
-        else
-        {
-            outputFail = output.substr(0,found) + "/" + "FailedLines_2_" + output.substr(found+1);
-        }
-        outputFile.open (outputFail, std::ofstream::app);
+        outputFile.open (prefixed_output_path(input.outFile, "FailedLines_2_"), std::ofstream::app);
         
         outputFile << failedLine.second << "\n";
         
@@ -171,19 +138,10 @@ void write_failed_line(const input& input, std::pair<const std::string&, const s
 /// write mapped barcodes to a tab separated file
 void write_file(const input& input, BarcodeMappingVector barcodes, std::string nameTag = "")
 {
-    std::string output = input.outFile;
+    std::string output = prefixed_output_path(input.outFile, "Demultiplexed_" + nameTag);
     std::ofstream outputFile;
-    std::size_t found = output.find_last_of("/");
 
     //write the barcodes we mapped
-    if(found == std::string::npos)
-    {
-        output = "Demultiplexed_" + nameTag + output;
-    }
-    else
-    {
-        output = output.substr(0,found) + "/" + "Demultiplexed_" + nameTag + output.substr(found+1);
-    }
     outputFile.open (output, std::ofstream::app);
     for(int i = 0; i < barcodes.size(); ++i)
     {
@@ -214,15 +172,13 @@ void DemultiplexedLinesWriter<MappingPolicy, FilePolicy>::initialize_output_file
 
 
 /**
-* @brief function wrapping the demultiplex_read function of the Mapping class to increment and decrement a counter of elements
-* in the current queue. Used to allow processing of only a few lines a time instead of writing all into RAM.
+* @brief function wrapping the demultiplex_read function of the Mapping class, called for every read of a batch in the thread pool.
 **/
 template <typename MappingPolicy, typename FilePolicy>
 void DemultiplexedLinesWriter<MappingPolicy, FilePolicy>::demultiplex_wrapper(std::pair<const std::string&, const std::string&> line,
                                                             const input& input,
                                                             std::atomic<unsigned long long>& lineCount,
-                                                            const unsigned long long& totalReadCount,
-                                                            std::atomic<long long int>& elementsInQueue)
+                                                            const unsigned long long& totalReadCount)
 {
     //firstly try mapping an AB read
     bool result = this->demultiplex_read(line, input, lineCount, totalReadCount, false);
@@ -236,7 +192,6 @@ void DemultiplexedLinesWriter<MappingPolicy, FilePolicy>::demultiplex_wrapper(st
         //write failed line to file
         write_failed_line(input, line);
     }
-    --elementsInQueue;
 }
 
 /// overwritten run_mapping function to allow processing of only a subset of fastq lines at a time
@@ -245,35 +200,25 @@ void DemultiplexedLinesWriter<MappingPolicy, FilePolicy>::run_mapping(const inpu
 {
     std::cout << "START DEMULTIPLEXING\n";
 
-    //generate a pool of threads
-    boost::asio::thread_pool pool(input.threads); //create thread pool
-
-    //read line by line and add to thread pool
+    //read the file in batches and map them in the thread pool, the number of reads in the queue is limited by the bucket size
     this->FilePolicy::init_file(input.inFile, input.reverseFile);
-    std::pair<std::string, std::string> line;
     std::atomic<unsigned long long> lineCount = 0; //using atomic<int> as thread safe read count
-    std::atomic<long long int> elementsInQueue = 0;
     unsigned long long totalReadCount = FilePolicy::get_read_number();
 
-    while(FilePolicy::get_next_line(line))
-    {
-        //wait to enqueue new elements in case we have a maximum bucket size
-        if(input.fastqReadBucketSize>0)
-        {
-            while(input.fastqReadBucketSize <= elementsInQueue){}
-        }
-        //increase job count and push the job in the queue
-        ++elementsInQueue;
-        boost::asio::post(pool, std::bind(&DemultiplexedLinesWriter::demultiplex_wrapper, this, line, input, std::ref(lineCount), totalReadCount, std::ref(elementsInQueue)));
-    }
-    pool.join();
+    this->map_reads_in_batches(input, [this, &input, &lineCount, &totalReadCount](std::pair<const std::string&, const std::string&> line)
+                               {
+                                   demultiplex_wrapper(line, input, lineCount, totalReadCount);
+                               });
     printProgress(1); std::cout << "\n"; // end the progress bar
     if(totalReadCount != ULLONG_MAX)
     {
         std::cout << "=>\tPERFECT MATCHES: " << std::to_string((unsigned long long)(100*(this->get_perfect_matches())/(double)totalReadCount)) 
                 << "% | MODERATE MATCHES: " << std::to_string((unsigned long long)(100*(this->get_moderat_matches())/(double)totalReadCount))
-                << "% | MISMATCHES: " << std::to_string((unsigned long long)(100*(this->get_failed_matches())/(double)totalReadCount)) << "%\n";
+                << "% | MISMATCHES: " << std::to_string((unsigned long long)(100*(this->get_failed_matches())/(double)totalReadCount))
+                << "% | EXACT LAYOUT (NO ALIGNMENT): " << std::to_string((unsigned long long)(100*(this->get_exact_layout_matches())/(double)totalReadCount)) << "%\n";
     }
+    this->print_result_cache_stats();
+    this->print_traceback_warnings();
 
     FilePolicy::close_file();
 }
@@ -306,6 +251,10 @@ void DemultiplexedLinesWriter<MappingPolicy, FilePolicy>::run(const input& input
     write_file(input, this->get_demultiplexed_ab_reads());
     write_file(input, this->get_demultiplexed_guide_reads(), guideNameTage);
     write_stats(input, this->get_mismatch_dict());
+    if(input.writeStats)
+    {
+        write_matching_plan(input, this->get_matching_plan());
+    }
 }
 
 template class DemultiplexedLinesWriter<MapEachBarcodeSequentiallyPolicy, ExtractLinesFromFastqFilePolicy>;
@@ -50,6 +50,7 @@
  *          After running a line of perfect, moderate and mismatches is printed. Each count refers to a whole line (all barcodes matched perfectly,
  *          at least one matched only with mismatches, at least one did not match at all. The number of duplicate barcodes is per barcode, and thus might
  *          be greater than the total number of mismatches.)
+ *          The share of lines whose barcodes all matched exactly at their expected positions (without any alignment) is printed as exact layout.
  * 
  *          barcode file: Output file starts with 'BarcodeMapping_' and ends with the ending extension declared with the -o paramter
  *          stats file: a list where for each barcode in the fastq file, the number of found mismatches is written, the columns start with zero mismatches
@@ -84,7 +85,10 @@ bool parse_arguments(char** argv, int argc, input& input)
             instead of the AB barcode. By default guide reads have also no UMI. If guide reads also contain a UMI set the flag guideUMI.")
             ("mismatches,m", value<std::string>(&(input.mismatchLine))->default_value("1"), "list of mismatches allowed for each bracket enclosed sequence substring. \
             This should be a comma seperated list of numbers for each substring of the sequence enclosed in squared brackets. E.g.: 2,1,2,1,2. (Also add the STOP, UMI mismatch -  \
-            this number is not used however, UMIs are aligned in BarcodeProcessing.)")
+            this number is not used however, UMIs are aligned in BarcodeProcessing.) Mismatches of variable barcodes with a leading h (e.g. h1) \
+            allow only substitutions: barcodes are matched with the Hamming distance and only aligned if no barcode is within the mismatches. \
+            With a leading a (e.g. a1, up to 2 mismatches) variable barcodes are matched with a Levenshtein automaton on a prefix tree of the barcodes \
+            (same results as the alignment, independent of the size of the barcode list).")
             ("guideUMI,d", value<bool>(&(input.guideUMI))->default_value(false), "set this flag to true if the guide reads have a UMI as well - only for demultiplexing \
             guide and AB reads simultaniously.")
             ("guidePosition,e", value<int>(&(input.guidePos))->default_value(-1), "position of all variable barcodes (in other words line in the barcodeFile), where the guide should be (0-indexed). This parameter needs\
@@ -92,10 +96,21 @@ bool parse_arguments(char** argv, int argc, input& input)
 
             ("threat,t", value<int>(&(input.threads))->default_value(5), "number of threads")
             ("fastqReadBucketSize,s", value<long long int>(&(input.fastqReadBucketSize))->default_value(-1), "number of lines of the fastQ file that should be read into RAM \
-            and be processed, before the next fastq read is processed. By default it equal 10X the thread number.")
-            ("writeStats,q", value<bool>(&(input.writeStats))->default_value(false), "writing Statistics about the barcode mapping (mismatches in different barcodes). This only works for simple\
+            and be processed, before the next fastq read is processed. Reads are mapped in batches of up to 1024 reads, smaller buckets use smaller \
+            batches (a quarter of the bucket per thread). By default the bucket holds four full batches per thread.")
+            ("writeStats,q", value<bool>(&(input.writeStats))->default_value(false), "writing Statistics about the barcode mapping (mismatches in different barcodes, and the matching plan of the variable barcodes). This only works for simple\
             mapping tasks without additional guide read mapping.\n")
             ("writeFailedLines,f", value<bool>(&(input.writeFailedLines))->default_value(false), "write failed lines to extra file\n")
+            ("matchCacheSize,x", value<int>(&(input.matchCacheSize))->default_value(0), "number of results of barcode matching that are cached per variable barcode. Reads \
+            with a previously seen sequence at the position of the barcode reuse the cached result. Only worth it if matching a barcode is expensive \
+            (e.g. long barcodes or many mismatches, where the exact and neighbourhood indexes do not answer). 0 (default) disables the cache.\n")
+            ("readCacheSize,u", value<int>(&(input.readCacheSize))->default_value(0), "number of whole reads (or read pairs) whose mapping is cached, \
+            for libraries with many duplicated reads. A read is cached when it is seen the second time, further duplicates are not mapped again, \
+            their barcodes and statistics are taken from the cache. 0 (default) disables the cache.\n")
+            ("offsetModelReads,l", value<unsigned long long>(&(input.offsetModelReads))->default_value(0), "number of reads that are mapped with all windows \
+            to learn how far the barcodes are shifted from their expected positions (e.g. by staggered primers). Afterwards each barcode is first matched exactly at the most \
+            frequent shifts and only aligned unless exactly one of them matches perfectly. This can change the result: a barcode that matches exactly at a learned shift \
+            is taken even if it also maps with mismatches closer to its expected position. The warm-up is mapped on one thread. 0 disables the learned offsets.\n")
 
             ("help,h", "help message");
 
@@ -133,10 +148,10 @@ int main(int argc, char** argv)
     input input;
     if(parse_arguments(argv, argc, input))
     {
-        //set the number of reads in the processing queue by default to 10X number of threads
+        //set the number of reads in the processing queue by default to four batches of reads per thread
         if(input.fastqReadBucketSize == -1)
         {
-            input.fastqReadBucketSize = input.threads * 10;
+            input.fastqReadBucketSize = input.threads * 4 * READ_BATCH_SIZE;
         }
         //check that we have the necessary parameters in case we also perform simultaniously guide mapping
         if( (input.guideFile != "" && input.guidePos == -1) || (input.guideFile == "" && input.guidePos != -1))